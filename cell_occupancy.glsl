@@ -0,0 +1,30 @@
+// occupancy bitmask from vulkan_renderer.hpp: one bit per cell that draws something,
+// one uint per occupancy_word_cells cells of a row, rows start at pane.occupancy_offset.
+const uint occupancy_word_cells = 32;
+const uint max_occupancy_words_per_row = 32;
+const uint rows_per_task_workgroup = 32;
+// cells drawn by one mesh workgroup, 32 or 64. Each value is a compiled variant, mesh_renderer picks
+// the one whose outputs fit the device limits.
+#ifndef MESHLET_CELLS
+#define MESHLET_CELLS 64
+#endif
+const uint meshlet_cells = MESHLET_CELLS;
+const uint meshlet_words = meshlet_cells / occupancy_word_cells;
+
+layout(std430, binding=3) readonly buffer occupancy_buffer {
+    uint occupancy[];
+};
+
+uint occupancy_words_per_row(uint width) {
+    return (width + occupancy_word_cells - 1) / occupancy_word_cells;
+}
+uint occupancy_word(uint row, uint word, uint width) {
+    uint words_per_row = occupancy_words_per_row(width);
+    return word < words_per_row ? occupancy[pane.occupancy_offset + row * words_per_row + word] : 0u;
+}
+
+// a meshlet is meshlet_words occupancy words with a visible cell, packed as row << 16 | meshlet index in the row.
+struct meshlet_payload {
+    uint meshlets[rows_per_task_workgroup * max_occupancy_words_per_row];
+};
+taskPayloadSharedEXT meshlet_payload payload;
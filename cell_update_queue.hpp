@@ -0,0 +1,60 @@
+#pragma once
+
+#include "terminal_cell.hpp"
+#include "spsc_queue.hpp"
+
+#include <algorithm>
+#include <span>
+#include <vector>
+
+// sets count cells of row y of a pane, starting at column x, to cell.
+struct cell_update {
+    uint32_t pane;
+    uint32_t x;
+    uint32_t y;
+    uint32_t count;
+    terminal_cell cell;
+};
+
+using cell_update_queue = spsc_queue<cell_update, 1 << 14>;
+
+// Producer side helper for the parser thread. Writes are batched locally and published by flush,
+// what does not fit into the queue stays pending for the next flush instead of blocking.
+class cell_update_writer {
+public:
+    cell_update_writer(cell_update_queue& queue) : m_queue{ queue }, m_pending{}, m_published{} {}
+    void write_cell(uint32_t pane, uint32_t x, uint32_t y, const terminal_cell& cell) {
+        fill(pane, x, y, 1, cell);
+    }
+    void fill(uint32_t pane, uint32_t x, uint32_t y, uint32_t count, const terminal_cell& cell) {
+        if (m_pending.size() > m_published) {
+            auto& last = m_pending.back();
+            if (last.pane == pane && last.y == y && last.x + last.count == x && last.cell == cell) {
+                last.count += count;
+                return;
+            }
+        }
+        m_pending.emplace_back(cell_update{ pane, x, y, count, cell });
+    }
+    // runs of equal cells are sent as a single update.
+    void write_row(uint32_t pane, uint32_t y, std::span<const terminal_cell> cells, uint32_t first_x = 0) {
+        for (auto run = cells.begin(); run != cells.end();) {
+            auto end = std::find_if(run, cells.end(), [&cell = *run](auto& other) { return other != cell; });
+            fill(pane, first_x + static_cast<uint32_t>(run - cells.begin()), y, static_cast<uint32_t>(end - run), *run);
+            run = end;
+        }
+    }
+    // true if everything written so far is visible to the renderer.
+    bool flush() {
+        m_published += m_queue.try_push(std::span<const cell_update>{ m_pending }.subspan(m_published));
+        if (m_published == m_pending.size()) {
+            m_pending.clear();
+            m_published = 0;
+        }
+        return m_pending.empty();
+    }
+private:
+    cell_update_queue& m_queue;
+    std::vector<cell_update> m_pending;
+    size_t m_published;
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "vulkan_utility.hpp"
+#include "glyph_atlas.hpp"
+#include "upload_queue.hpp"
+
+#include <mutex>
+
+// Device level objects shared by every window on a physical device: device, queue family,
+// glyph atlas, pipeline cache, buffer memory pool and upload queue. A window attaching to an existing
+// context only creates its surface resources, swapchain and per window buffers.
+// Windows may render from their own threads: the atlas is guarded by the context's mutex, the memory pool
+// locks itself and the queues are submitted to under the upload queue's lock_queues.
+class device_context {
+public:
+    device_context(vk::SharedPhysicalDevice physical_device, vk::SharedDevice device, uint32_t queue_family_index)
+        : m_physical_device{ physical_device },
+        m_device{ device },
+        m_queue_family_index{ queue_family_index },
+        m_pipeline_cache{ device->createPipelineCache(vk::PipelineCacheCreateInfo{}), device },
+        m_memory_pool{ std::make_shared<vulkan::memory_pool>(physical_device, device) },
+        m_upload_queue{ std::make_shared<upload_queue>(device, queue_family_index,
+            vulkan::select_transfer_queue_family(*physical_device, queue_family_index)) } {}
+    static std::shared_ptr<device_context> get_or_create(
+        vk::SharedPhysicalDevice physical_device, uint32_t queue_family_index, auto&& create_device) {
+        static std::mutex contexts_mutex;
+        static std::map<vk::PhysicalDevice, std::weak_ptr<device_context>> contexts;
+        std::lock_guard lock{ contexts_mutex };
+        auto& context = contexts[*physical_device];
+        if (auto existing_context = context.lock()) {
+            return existing_context;
+        }
+        auto new_context = std::make_shared<device_context>(physical_device, create_device(), queue_family_index);
+        context = new_context;
+        return new_context;
+    }
+    auto get_vulkan_physical_device() {
+        return *m_physical_device;
+    }
+    auto get_vulkan_shared_physical_device() {
+        return m_physical_device;
+    }
+    auto get_vulkan_device() {
+        return *m_device;
+    }
+    auto get_vulkan_shared_device() {
+        return m_device;
+    }
+    auto get_queue_family_index() {
+        return m_queue_family_index;
+    }
+    auto get_pipeline_cache() {
+        return m_pipeline_cache;
+    }
+    auto get_memory_pool() {
+        return m_memory_pool;
+    }
+    auto get_upload_queue() {
+        return m_upload_queue;
+    }
+    auto get_glyph_atlas() {
+        std::lock_guard lock{ m_mutex };
+        return m_glyph_atlas;
+    }
+    // windows still drawing with the previous atlas keep it alive until their next update.
+    void set_glyph_atlas(std::shared_ptr<glyph_atlas> atlas) {
+        std::lock_guard lock{ m_mutex };
+        m_glyph_atlas = atlas;
+    }
+    // held while a presenter checks and submits the acquire of a shared atlas, so only one of them does.
+    std::unique_lock<std::mutex> lock_glyph_atlas() {
+        return std::unique_lock{ m_mutex };
+    }
+private:
+    vk::SharedPhysicalDevice m_physical_device;
+    vk::SharedDevice m_device;
+    uint32_t m_queue_family_index;
+    vk::SharedPipelineCache m_pipeline_cache;
+    std::shared_ptr<vulkan::memory_pool> m_memory_pool;
+    std::shared_ptr<upload_queue> m_upload_queue;
+    std::mutex m_mutex;
+    std::shared_ptr<glyph_atlas> m_glyph_atlas;
+};
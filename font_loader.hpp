@@ -1,7 +1,9 @@
 #pragma once
 
 #include <exception>
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <map>
 #include <string>
 #include <stdexcept>
@@ -12,9 +14,70 @@
 
 #include "build_info.hpp"
 
+// Open addressing codepoint -> (face, glyph index) table, so probing the fallback faces with
+// FT_Get_Char_Index happens once per codepoint.
+class glyph_lookup_cache {
+public:
+    struct glyph_location {
+        uint32_t face_index;
+        FT_UInt glyph_index;
+    };
+    glyph_lookup_cache() : m_entries(64), m_count{} {}
+    const glyph_location* find(uint32_t codepoint) const {
+        for (auto i = hash(codepoint);; i++) {
+            auto& entry = m_entries[i & (m_entries.size() - 1)];
+            if (!entry.occupied) {
+                return nullptr;
+            }
+            if (entry.codepoint == codepoint) {
+                return &entry.location;
+            }
+        }
+    }
+    void insert(uint32_t codepoint, glyph_location location) {
+        if ((m_count + 1) * 4 > m_entries.size() * 3) {
+            grow();
+        }
+        for (auto i = hash(codepoint);; i++) {
+            auto& entry = m_entries[i & (m_entries.size() - 1)];
+            if (!entry.occupied) {
+                entry = entry_type{ true, codepoint, location };
+                m_count++;
+                return;
+            }
+            if (entry.codepoint == codepoint) {
+                entry.location = location;
+                return;
+            }
+        }
+    }
+private:
+    // every codepoint value is a valid key, so free slots are marked separately.
+    struct entry_type {
+        bool occupied{};
+        uint32_t codepoint{};
+        glyph_location location{};
+    };
+    static size_t hash(uint32_t codepoint) {
+        return static_cast<size_t>(codepoint * 0x9e3779b1u);
+    }
+    void grow() {
+        auto entries = std::move(m_entries);
+        m_entries = std::vector<entry_type>(entries.size() * 2);
+        m_count = 0;
+        for (auto& entry : entries) {
+            if (entry.occupied) {
+                insert(entry.codepoint, entry.location);
+            }
+        }
+    }
+    std::vector<entry_type> m_entries;
+    size_t m_count;
+};
+
 class font_loader {
 public:
-    font_loader() {
+    font_loader() : m_char_width{ 0 }, m_char_height{ 16 * 64 }, m_resolution{ 512 } {
 		if (FT_Init_FreeType(&m_library)) {
 			throw std::runtime_error{ "failed to initialize font library" };
 		}
@@ -26,49 +89,118 @@ public:
         os_font_paths[os::eLinux].emplace_back("/usr/share/fonts/gnu-free/FreeMono.otf");
 		os_font_paths[os::eLinux].emplace_back("/usr/share/fonts/truetype/freefont/FreeMono.ttf");
 		const auto& font_paths = os_font_paths[build_info::runtime_os];
+        FT_Face face{};
         if (font_paths.end() ==std::find_if(
                 font_paths.begin(), font_paths.end(),
-                [&library=m_library, &face=m_face](auto& font_path) {
+                [&library=m_library, &face](auto& font_path) {
                     return 0 == FT_New_Face(library, font_path.c_str(), 0, &face);
                 })) {
             throw std::runtime_error{ "failed to open font file" };
         }
-		if (FT_Set_Char_Size(m_face, 0, 16 * 64, 512, 512)) {
-			throw std::runtime_error{ "failed to set font size" };
-		}
-        m_glyph = m_face->glyph;
+        set_face_size(face);
+        m_faces.emplace_back(face_slot{ {}, face, true });
+
+        // fallback faces are only opened when a codepoint is missing from every face opened so far.
+        auto os_fallback_font_paths = std::map<os, std::vector<std::string>>{
+            {os::eWindows, {"C:/Windows/Fonts/seguisym.ttf", "C:/Windows/Fonts/msgothic.ttc"}},
+            {os::eLinux, {
+                "/usr/share/fonts/truetype/dejavu/DejaVuSansMono.ttf",
+                "/usr/share/fonts/TTF/DejaVuSansMono.ttf",
+                "/usr/share/fonts/noto/NotoSansMono-Regular.ttf",
+                "/usr/share/fonts/opentype/noto/NotoSansCJK-Regular.ttc",
+                "/usr/share/fonts/noto-cjk/NotoSansCJK-Regular.ttc"}},
+        };
+        for (auto& path : os_fallback_font_paths[build_info::runtime_os]) {
+            m_faces.emplace_back(face_slot{ path, nullptr, false });
+        }
+        m_glyph = m_faces.front().face->glyph;
     }
 	~font_loader() {
-		FT_Done_Face(m_face);
+        for (auto& slot : m_faces) {
+            if (slot.face) {
+                FT_Done_Face(slot.face);
+            }
+        }
 		FT_Done_FreeType(m_library);
 	}
 	void set_char_size(uint32_t width, uint32_t height) {
-		if (FT_Set_Char_Size(m_face, width<<6, height<<6, 72, 72)) {
-			throw std::runtime_error{ "failed to set font size" };
-		}
+        m_char_width = width << 6;
+        m_char_height = height << 6;
+        m_resolution = 72;
+        for (auto& slot : m_faces) {
+            if (slot.face) {
+                set_face_size(slot.face);
+            }
+        }
 	}
 	void render_char(char c) {
-		if (c == '\0') {
-			c = ' ';
-		}
-		auto glyph_index = FT_Get_Char_Index(m_face, c);
-		if (glyph_index == 0) {
-			c = '?';
-			glyph_index = FT_Get_Char_Index(m_face, c);
+        render_char(static_cast<uint32_t>(static_cast<unsigned char>(c)));
+	}
+	void render_char(uint32_t codepoint) {
+		if (codepoint == '\0') {
+			codepoint = ' ';
 		}
-		assert(glyph_index != 0);
-		if (FT_Load_Glyph(m_face, glyph_index, FT_LOAD_DEFAULT)) {
+        auto location = find_glyph(codepoint);
+        auto face = m_faces[location.face_index].face;
+		if (FT_Load_Glyph(face, location.glyph_index, FT_LOAD_DEFAULT)) {
 			throw std::runtime_error{ "failed to load glyph" };
 		}
-		if (FT_Render_Glyph(m_face->glyph, FT_RENDER_MODE_NORMAL)) {
+		if (FT_Render_Glyph(face->glyph, FT_RENDER_MODE_NORMAL)) {
 			throw std::runtime_error{ "failed to render glyph" };
 		}
+        m_glyph = face->glyph;
 	}
     auto get_glyph() {
         return m_glyph;
     }
 private:
+    struct face_slot {
+        std::string path;
+        FT_Face face;
+        bool tried;
+    };
+    void set_face_size(FT_Face face) {
+		if (FT_Set_Char_Size(face, m_char_width, m_char_height, m_resolution, m_resolution)) {
+			throw std::runtime_error{ "failed to set font size" };
+		}
+    }
+    // opened faces first, then the unopened fallbacks in order, and '?' of the first face if none has it.
+    glyph_lookup_cache::glyph_location find_glyph(uint32_t codepoint) {
+        if (auto location = m_glyph_cache.find(codepoint)) {
+            return *location;
+        }
+        auto location = glyph_lookup_cache::glyph_location{ 0, 0 };
+        for (uint32_t i = 0; i < m_faces.size(); i++) {
+            auto& slot = m_faces[i];
+            if (!slot.tried) {
+                slot.tried = true;
+                if (FT_New_Face(m_library, slot.path.c_str(), 0, &slot.face)) {
+                    slot.face = nullptr;
+                }
+                else {
+                    set_face_size(slot.face);
+                }
+            }
+            if (slot.face == nullptr) {
+                continue;
+            }
+            if (auto glyph_index = FT_Get_Char_Index(slot.face, codepoint)) {
+                location = glyph_lookup_cache::glyph_location{ i, glyph_index };
+                break;
+            }
+        }
+        if (location.glyph_index == 0) {
+            location = glyph_lookup_cache::glyph_location{ 0, FT_Get_Char_Index(m_faces.front().face, '?') };
+            assert(location.glyph_index != 0);
+        }
+        m_glyph_cache.insert(codepoint, location);
+        return location;
+    }
 	FT_Library m_library;
-	FT_Face m_face;
+    std::vector<face_slot> m_faces;
+    glyph_lookup_cache m_glyph_cache;
+    FT_F26Dot6 m_char_width;
+    FT_F26Dot6 m_char_height;
+    FT_UInt m_resolution;
     FT_GlyphSlot m_glyph;
 };
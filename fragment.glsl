@@ -1,11 +1,48 @@
 #version 460
+#extension GL_GOOGLE_include_directive : require
 
-layout(location=0) in vec2 coord;
+#include "packed_cell.glsl"
+
+const vec2 underline_range = vec2(0.52, 0.55);
+const vec2 strikethrough_range = vec2(0.36, 0.39);
+
+layout(location=0) flat in vec4 glyph_uv;
+layout(location=1) in vec2 cell_coord;
+layout(location=2) flat in vec3 foreground;
+layout(location=3) flat in vec3 background;
+layout(location=4) flat in uint style;
+layout(location=5) flat in vec4 glyph_box;
+layout(location=6) flat in uint glyph_layer;
 layout(location=0) out vec4 out_color;
-layout(binding=0) uniform sampler2D tex_sampler;
+layout(binding=0) uniform sampler2DArray tex_sampler;
+
+bool in_range(float v, vec2 range) {
+    return v >= range.x && v < range.y;
+}
+
+// texel of the glyph's packed bitmap under this point of the cell, 0 outside the bitmap.
+// the lookup is clamped rather than skipped so fwidth stays in uniform control flow.
+float sample_glyph() {
+    vec2 local = (cell_coord - glyph_box.xy) / glyph_box.zw;
+    float value = texture(tex_sampler, vec3(glyph_uv.xy + clamp(local, 0.0, 1.0) * glyph_uv.zw, glyph_layer)).x;
+    bool inside = all(greaterThanEqual(local, vec2(0))) && all(lessThanEqual(local, vec2(1)));
+    return inside ? value : 0.0;
+}
 
 void main() {
-    float a = texture(tex_sampler, coord).x;
-    vec3 color = vec3(0, 0, 0);
-    out_color = vec4(color,a);
-}
\ No newline at end of file
+#ifdef SDF_ATLAS
+    // 0.5 is the outline, the smoothing width follows the screen space rate of change.
+    float distance = sample_glyph();
+    float smoothing = max(fwidth(distance), 1e-4);
+    float a = smoothstep(0.5 - smoothing, 0.5 + smoothing, distance);
+#else
+    float a = sample_glyph();
+#endif
+    if ((style & cell_style_underline) != 0u && in_range(cell_coord.y, underline_range)) {
+        a = 1;
+    }
+    if ((style & cell_style_strikethrough) != 0u && in_range(cell_coord.y, strikethrough_range)) {
+        a = 1;
+    }
+    out_color = vec4(mix(background, foreground, a), 1);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "vulkan_utility.hpp"
+
+#include <atomic>
+
+// glyph_rects.glsl, where a glyph is in the atlas and where its bitmap sits in the cell.
+struct glyph_rect {
+    // top left and size in texture coordinates of the layer.
+    std::array<float, 4> uv;
+    // top left and size in cell units, a cell is one glyph_tile_metrics tile.
+    std::array<float, 4> box;
+    uint32_t layer;
+    uint32_t padding[3];
+};
+static_assert(sizeof(glyph_rect) == 48);
+
+struct glyph_atlas {
+    // a rebuilt atlas keeps the glyphs of the one it replaces only up to this count, so it does not grow
+    // with every glyph ever drawn. Glyphs that do not fit the texture layers make the rebuild throw.
+    static constexpr size_t max_kept_glyph_count = 1 << 16;
+    vk::SharedImage texture;
+    vk::SharedDeviceMemory texture_memory;
+    // a 2D array view of the packed glyph bitmaps.
+    vk::SharedImageView texture_view;
+    uint32_t layers;
+    // one glyph_rect per glyph index.
+    vk::SharedBuffer glyph_rects_buffer;
+    std::shared_ptr<vulkan::memory_pool::allocation> glyph_rects_allocation;
+    std::vector<uint32_t> characters;
+    std::map<uint32_t, int> char_texture_indices;
+    // texels hold signed distances instead of coverage, drawn with fragment_sdf.
+    bool is_sdf;
+    // upload_queue value signaled once the texture is uploaded.
+    uint64_t upload_value;
+    // whether the graphics queue has taken ownership of the uploaded texture, done by the first presenter using it.
+    std::atomic<bool> acquired;
+
+    bool contains(const std::set<uint32_t>& char_set) const {
+        return std::ranges::all_of(char_set, [this](auto c) {
+            return char_texture_indices.contains(c);
+            });
+    }
+};
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "font_loader.hpp"
+#include "glyph_tiles.hpp"
+#include "signed_distance_field.hpp"
+
+// side of an atlas layer unless the device allows less.
+inline constexpr uint32_t glyph_atlas_page_size = 2048;
+
+// Bottom left skyline packing of rectangles into a width x height area. The skyline is the top edge of
+// everything placed so far, a rectangle goes where it ends lowest, the leftmost such place on ties.
+class skyline_packer {
+public:
+    struct position {
+        uint32_t x;
+        uint32_t y;
+    };
+    skyline_packer(uint32_t width, uint32_t height)
+        : m_width{ width }, m_height{ height }, m_used_height{ 0 }, m_skyline{ segment{ 0, 0, width } } {}
+    std::optional<position> insert(uint32_t width, uint32_t height) {
+        if (width > m_width || height > m_height) {
+            return std::nullopt;
+        }
+        std::optional<size_t> best_index;
+        uint32_t best_y = UINT32_MAX;
+        for (size_t i = 0; i < m_skyline.size(); i++) {
+            if (auto y = fit(i, width, height); y && *y < best_y) {
+                best_index = i;
+                best_y = *y;
+            }
+        }
+        if (!best_index) {
+            return std::nullopt;
+        }
+        auto result = position{ m_skyline[*best_index].x, best_y };
+        add_segment(*best_index, segment{ result.x, best_y + height, width });
+        m_used_height = std::max(m_used_height, best_y + height);
+        return result;
+    }
+    uint32_t get_used_height() const {
+        return m_used_height;
+    }
+private:
+    struct segment {
+        uint32_t x;
+        uint32_t y;
+        uint32_t width;
+    };
+    // y of a rectangle whose left edge is at segment index, it rests on the highest segment it spans.
+    std::optional<uint32_t> fit(size_t index, uint32_t width, uint32_t height) const {
+        if (m_skyline[index].x + width > m_width) {
+            return std::nullopt;
+        }
+        uint32_t y = 0;
+        int64_t remaining = width;
+        for (size_t i = index; remaining > 0; i++) {
+            y = std::max(y, m_skyline[i].y);
+            if (y + height > m_height) {
+                return std::nullopt;
+            }
+            remaining -= m_skyline[i].width;
+        }
+        return y;
+    }
+    // the new segment covers the start of the skyline from index on, the segments under it shrink or go.
+    void add_segment(size_t index, segment new_segment) {
+        m_skyline.insert(m_skyline.begin() + index, new_segment);
+        auto end = new_segment.x + new_segment.width;
+        for (auto i = index + 1; i < m_skyline.size();) {
+            auto& next = m_skyline[i];
+            if (next.x >= end) {
+                break;
+            }
+            auto shrink = std::min(end - next.x, next.width);
+            next.x += shrink;
+            next.width -= shrink;
+            if (next.width == 0) {
+                m_skyline.erase(m_skyline.begin() + i);
+            }
+            else {
+                break;
+            }
+        }
+        for (size_t i = 0; i + 1 < m_skyline.size();) {
+            if (m_skyline[i].y == m_skyline[i + 1].y) {
+                m_skyline[i].width += m_skyline[i + 1].width;
+                m_skyline.erase(m_skyline.begin() + i + 1);
+            }
+            else {
+                i++;
+            }
+        }
+    }
+    uint32_t m_width;
+    uint32_t m_height;
+    uint32_t m_used_height;
+    std::vector<segment> m_skyline;
+};
+
+// rasterizes every character at the tile metrics, the distance field conversion is split between threads.
+// fonts is kept by the caller between calls, so its fallback faces and glyph lookups are reused.
+template<class Character>
+inline std::vector<glyph_bitmap> render_glyph_bitmaps(font_loader& fonts, const std::vector<Character>& characters,
+    glyph_tile_metrics metrics, uint32_t padding, bool sdf, float sdf_spread) {
+    std::vector<glyph_bitmap> bitmaps;
+    bitmaps.reserve(characters.size());
+    fonts.set_char_size(metrics.font_width, metrics.font_height);
+    for (auto character : characters) {
+        fonts.render_char(character);
+        auto glyph = fonts.get_glyph();
+        auto bitmap = glyph_bitmap{
+            glyph->bitmap.width + 2 * padding, glyph->bitmap.rows + 2 * padding,
+            glyph->bitmap_left - static_cast<int32_t>(padding),
+            static_cast<int32_t>(metrics.font_height) - glyph->bitmap_top - 1 - static_cast<int32_t>(padding),
+            {} };
+        bitmap.pixels.resize(size_t{ bitmap.width } * bitmap.height);
+        for (uint32_t row = 0; row < glyph->bitmap.rows; row++) {
+            std::copy_n(glyph->bitmap.buffer + row * glyph->bitmap.pitch, glyph->bitmap.width,
+                bitmap.pixels.data() + (row + padding) * bitmap.width + padding);
+        }
+        bitmaps.emplace_back(std::move(bitmap));
+    }
+    if (sdf) {
+        size_t thread_count = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, std::max<size_t>(bitmaps.size(), 1));
+        std::vector<std::jthread> threads;
+        for (size_t t = 0; t < thread_count; t++) {
+            threads.emplace_back([&bitmaps, t, thread_count, sdf_spread]() {
+                for (size_t i = t; i < bitmaps.size(); i += thread_count) {
+                    auto& bitmap = bitmaps[i];
+                    coverage_to_signed_distance_field(bitmap.pixels.data(), bitmap.width, bitmap.height, bitmap.width, sdf_spread);
+                }
+                });
+        }
+    }
+    return bitmaps;
+}
+
+// Where each glyph bitmap went in an atlas of layers of width x height pixels.
+struct glyph_packing {
+    struct placement {
+        uint32_t x;
+        uint32_t y;
+        uint32_t layer;
+    };
+    uint32_t width;
+    uint32_t height;
+    uint32_t layers;
+    std::vector<placement> placements;
+
+    size_t get_byte_size() const {
+        return size_t{ width } * height * layers;
+    }
+};
+
+// packs the tallest bitmaps first, they shape the skyline and the small ones fill the gaps. A new layer
+// starts when a bitmap does not fit the current one, a single layer is cut to the height it uses.
+inline glyph_packing pack_glyph_bitmaps(const std::vector<glyph_bitmap>& bitmaps, uint32_t page_size, uint32_t max_layers) {
+    std::vector<size_t> order(bitmaps.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::ranges::stable_sort(order, [&bitmaps](auto a, auto b) {
+        return bitmaps[a].height > bitmaps[b].height;
+        });
+    auto packing = glyph_packing{ page_size, page_size, 1, std::vector<glyph_packing::placement>(bitmaps.size()) };
+    auto packer = skyline_packer{ page_size, page_size };
+    for (auto i : order) {
+        auto position = packer.insert(bitmaps[i].width, bitmaps[i].height);
+        if (!position) {
+            if (++packing.layers > max_layers) {
+                throw std::runtime_error{ "glyph atlas exceeds the image array layer limit" };
+            }
+            packer = skyline_packer{ page_size, page_size };
+            position = packer.insert(bitmaps[i].width, bitmaps[i].height);
+            if (!position) {
+                throw std::runtime_error{ "glyph is larger than an atlas layer" };
+            }
+        }
+        packing.placements[i] = glyph_packing::placement{ position->x, position->y, packing.layers - 1 };
+    }
+    if (packing.layers == 1) {
+        packing.height = std::max(packer.get_used_height(), 1u);
+    }
+    return packing;
+}
+
+// copies the bitmaps to their places, ptr holds the layers one below the other with a pitch of packing.width.
+inline void write_packed_glyphs(const std::vector<glyph_bitmap>& bitmaps, const glyph_packing& packing, unsigned char* ptr) {
+    for (size_t i = 0; i < bitmaps.size(); i++) {
+        auto& bitmap = bitmaps[i];
+        auto& place = packing.placements[i];
+        auto origin = ptr + (size_t{ place.layer } * packing.height + place.y) * packing.width + place.x;
+        for (uint32_t row = 0; row < bitmap.height; row++) {
+            std::copy_n(bitmap.pixels.data() + row * bitmap.width, bitmap.width, origin + row * packing.width);
+        }
+    }
+}
@@ -0,0 +1,12 @@
+// glyph_rect from glyph_atlas.hpp, where a glyph is in the atlas and where its bitmap sits in the cell.
+struct glyph_rect {
+    // top left and size in texture coordinates of the layer.
+    vec4 uv;
+    // top left and size in cell units.
+    vec4 box;
+    uint layer;
+};
+
+layout(std430, binding=4) readonly buffer glyph_rects_buffer {
+    glyph_rect glyph_rects[];
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Size of one glyph tile of the atlas.
+struct glyph_tile_metrics {
+    uint32_t font_width = 32;
+    uint32_t font_height = 32;
+    uint32_t line_height = 64;
+};
+
+// glyph bitmap with a blank border of padding pixels, already converted when it is a distance field.
+struct glyph_bitmap {
+    uint32_t width;
+    uint32_t height;
+    // top left of the padded bitmap in pixels of the glyph tile, see glyph_tile_metrics.
+    int32_t left;
+    int32_t top;
+    std::vector<unsigned char> pixels;
+};
+
+// copies a bitmap from render_glyph_bitmaps into its font_width x line_height tile at ptr, only glyph pixels
+// are written. The parts of the bitmap outside the tile are cut off, glyphs may reach past their cell.
+inline void write_glyph_tile(const glyph_bitmap& bitmap, unsigned char* ptr, size_t pitch, glyph_tile_metrics metrics) {
+    auto left = std::max<int64_t>(bitmap.left, 0);
+    auto top = std::max<int64_t>(bitmap.top, 0);
+    auto right = std::min<int64_t>(int64_t{ bitmap.left } + bitmap.width, metrics.font_width);
+    auto bottom = std::min<int64_t>(int64_t{ bitmap.top } + bitmap.height, metrics.line_height);
+    if (left >= right || top >= bottom) {
+        return;
+    }
+    for (auto y = top; y < bottom; y++) {
+        auto source = bitmap.pixels.data() + (y - bitmap.top) * bitmap.width + (left - bitmap.left);
+        std::copy(source, source + (right - left), ptr + y * pitch + left);
+    }
+}
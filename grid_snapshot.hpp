@@ -0,0 +1,131 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "multidimention_array.hpp"
+
+template<class T>
+struct grid_row {
+    // unique per row content, a row that is copied on write gets a new version.
+    uint64_t version;
+    std::vector<T> cells;
+};
+
+// Immutable view of the whole grid. Unchanged rows are shared with the snapshots before and after it.
+template<class T>
+struct grid_snapshot {
+    size_t width;
+    size_t height;
+    uint64_t generation;
+    std::vector<std::shared_ptr<const grid_row<T>>> rows;
+
+    const T& operator[](std::pair<size_t, size_t> index) const {
+        auto [x, y] = index;
+        assert(x < width && y < height);
+        return rows[y]->cells[x];
+    }
+    void copy_row_to(size_t y, multidimention_vector<T>& grid) const {
+        std::ranges::copy(rows[y]->cells, grid.get_row(y).begin());
+    }
+};
+
+// One writer thread edits the grid and publishes complete snapshots, one reader thread always sees
+// the latest complete one. The three slots are handed over with a single atomic exchange, so neither
+// side waits and the reader never sees a half written row.
+template<class T>
+class triple_buffered_grid {
+public:
+    triple_buffered_grid(size_t width, size_t height)
+        : m_slots{}, m_ready{ 1 }, m_back{ 0 }, m_front{ 2 }, m_next_version{}, m_generation{} {
+        resize(width, height);
+        publish();
+    }
+
+    // writer side
+    size_t get_width() const {
+        return m_width;
+    }
+    size_t get_height() const {
+        return m_height;
+    }
+    void resize(size_t width, size_t height) {
+        m_width = width;
+        m_height = height;
+        m_rows.resize(height);
+        for (auto& row : m_rows) {
+            if (!row || row->cells.size() != width) {
+                auto cells = row ? row->cells : std::vector<T>{};
+                cells.resize(width);
+                row = std::make_shared<grid_row<T>>(grid_row<T>{ m_next_version++, std::move(cells) });
+            }
+        }
+    }
+    // the row is copied first if a published snapshot still shares it.
+    std::span<T> get_row(size_t y) {
+        auto& row = m_rows[y];
+        if (row.use_count() > 1) {
+            row = std::make_shared<grid_row<T>>(grid_row<T>{ m_next_version++, row->cells });
+        }
+        return row->cells;
+    }
+    // reads without copying the row.
+    std::span<const T> get_row(size_t y) const {
+        return m_rows[y]->cells;
+    }
+    void write(size_t x, size_t y, const T& value) {
+        assert(x < m_width && y < m_height);
+        get_row(y)[x] = value;
+    }
+    // like filling get_row(y), but a shared row is replaced instead of copied first.
+    void fill_row(size_t y, const T& value) {
+        auto& row = m_rows[y];
+        if (row.use_count() > 1) {
+            row = std::make_shared<grid_row<T>>(grid_row<T>{ m_next_version++, std::vector<T>(m_width, value) });
+        }
+        else {
+            std::ranges::fill(row->cells, value);
+        }
+    }
+    // rows middle..last-1 move up to first and the rows before them go below, no cell is copied.
+    void rotate_rows(size_t first, size_t middle, size_t last) {
+        assert(first <= middle && middle <= last && last <= m_height);
+        std::rotate(m_rows.begin() + first, m_rows.begin() + middle, m_rows.begin() + last);
+    }
+    void publish() {
+        auto& back = m_slots[m_back];
+        back.width = m_width;
+        back.height = m_height;
+        back.generation = ++m_generation;
+        back.rows.assign(m_rows.begin(), m_rows.end());
+        m_back = m_ready.exchange(m_back | fresh_bit, std::memory_order_acq_rel) & index_mask;
+        // drop the rows of the slot we got back, so they are not copied needlessly on the next write.
+        m_slots[m_back].rows.clear();
+    }
+
+    // reader side, the returned snapshot stays valid until the next read.
+    // rows must not be copied out of it, the writer's copy on write relies on use_count.
+    const grid_snapshot<T>& read() {
+        if (m_ready.load(std::memory_order_relaxed) & fresh_bit) {
+            m_front = m_ready.exchange(m_front, std::memory_order_acq_rel) & index_mask;
+        }
+        return m_slots[m_front];
+    }
+private:
+    static constexpr uint32_t index_mask = 0x3;
+    static constexpr uint32_t fresh_bit = 0x4;
+    std::array<grid_snapshot<T>, 3> m_slots;
+    std::atomic<uint32_t> m_ready;
+    uint32_t m_back;
+    uint32_t m_front;
+    std::vector<std::shared_ptr<grid_row<T>>> m_rows;
+    size_t m_width;
+    size_t m_height;
+    uint64_t m_next_version;
+    uint64_t m_generation;
+};
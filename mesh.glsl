@@ -1,60 +1,93 @@
 #version 460
 #extension GL_EXT_mesh_shader : enable
+#extension GL_GOOGLE_include_directive : require
 
-const int total_width = 32;
-const int total_height = 16;
+#include "packed_cell.glsl"
+#include "pane_parameters.glsl"
+#include "glyph_rects.glsl"
+#include "cell_occupancy.glsl"
 
-const int width = 32;
-const int height = 1;
-const float grid_width = 2.0 / total_width;
-const float grid_height = 2.0 / total_height;
-const vec2 grid_size = vec2(grid_width, grid_height);
-
-layout(constant_id=555) const int char_num = 22;
-
-
-layout(local_size_x=width/4,local_size_y=height) in;
-layout(max_primitives=width*height*2, max_vertices=width*height*6) out;
+// a workgroup draws the visible cells of one meshlet, task.glsl launches one per meshlet with a visible cell.
+// the outputs are declared for meshlet_cells, the variant mesh_renderer picks fits the device's output limits,
+// the workgroup size is specialized from them.
+layout(local_size_x_id=557) in;
+layout(max_primitives=meshlet_cells*2, max_vertices=meshlet_cells*4) out;
 layout(triangles) out;
 
-layout(std140, binding=1) uniform char_indices {
-    uvec4 indices[total_width/4*total_height];
-}tex_indices;
+layout(std430, binding=1) readonly buffer cells_buffer {
+    uint cells[];
+};
+layout(std140, binding=2) uniform palette_colors {
+    vec4 colors[256];
+} palette;
 
-layout(location=0) out vec2 coord[];
+layout(location=0) flat out vec4 glyph_uv[];
+layout(location=1) out vec2 cell_coord[];
+layout(location=2) flat out vec3 foreground[];
+layout(location=3) flat out vec3 background[];
+layout(location=4) flat out uint style[];
+layout(location=5) flat out vec4 glyph_box[];
+layout(location=6) flat out uint glyph_layer[];
 
-void set_pos(uint index, vec2 pos) {
-    gl_MeshVerticesEXT[index].gl_Position = vec4(pos, 0, 1);
+vec3 resolve_color(uint color, bool is_palette) {
+    return is_palette ? palette.colors[color & 0xffu].rgb : unpack_rgb(color);
 }
-void set_coord(uint index, vec2 c) {
-    coord[index] = c;
+
+void set_vertex(uint index, vec2 pos, vec2 grid_size, vec2 corner) {
+    gl_MeshVerticesEXT[index].gl_Position = vec4(pos + corner*grid_size, 0, 1);
+    cell_coord[index] = corner;
 }
 
-void draw_char(uint index, vec2 pos, uint primitive_index, uint vertex_index) {
-    vec2 pos1 = pos + vec2(1,0)*grid_size;
-    vec2 pos2 = pos + vec2(0,1)*grid_size;
-    vec2 pos3 = pos + vec2(1,1)*grid_size;
-    const float tex_width = 1.0 / char_num;
-    const float tex_advance = tex_width;
-    const float tex_offset = tex_width * index;
-    set_pos(vertex_index+0, pos); set_coord(vertex_index+0, vec2(tex_offset,0));
-    set_pos(vertex_index+1, pos1); set_coord(vertex_index+1, vec2(tex_offset+tex_advance,0));
-    set_pos(vertex_index+2, pos2); set_coord(vertex_index+2, vec2(tex_offset,1));
-    gl_PrimitiveTriangleIndicesEXT[primitive_index] = uvec3(vertex_index,vertex_index+1,vertex_index+2);
-    set_pos(vertex_index+3, pos1); set_coord(vertex_index+3, vec2(tex_offset+tex_advance,0));
-    set_pos(vertex_index+4, pos2); set_coord(vertex_index+4, vec2(tex_offset,1));
-    set_pos(vertex_index+5, pos3); set_coord(vertex_index+5, vec2(tex_offset+tex_advance,1));
-    gl_PrimitiveTriangleIndicesEXT[primitive_index+1] = uvec3(vertex_index+3,vertex_index+4,vertex_index+5);
+// one quad is 4 vertices shared by 2 indexed triangles.
+void draw_char(uvec3 cell, vec2 pos, vec2 grid_size, uint slot) {
+    uint vertex_index = slot*4;
+    uint primitive_index = slot*2;
+    set_vertex(vertex_index+0, pos, grid_size, vec2(0,0));
+    set_vertex(vertex_index+1, pos, grid_size, vec2(1,0));
+    set_vertex(vertex_index+2, pos, grid_size, vec2(0,1));
+    set_vertex(vertex_index+3, pos, grid_size, vec2(1,1));
+    gl_PrimitiveTriangleIndicesEXT[primitive_index] = uvec3(vertex_index, vertex_index+1, vertex_index+2);
+    gl_PrimitiveTriangleIndicesEXT[primitive_index+1] = uvec3(vertex_index+1, vertex_index+2, vertex_index+3);
 
+    uint cell_style_bits = cell_style(cell);
+    vec3 fg = resolve_color(cell_foreground(cell), (cell_style_bits & cell_style_foreground_palette) != 0u);
+    vec3 bg = resolve_color(cell_background(cell), (cell_style_bits & cell_style_background_palette) != 0u);
+    glyph_rect glyph = glyph_rects[cell_glyph_index(cell)];
+    for (uint i = vertex_index; i < vertex_index+4; i++) {
+        foreground[i] = fg;
+        background[i] = bg;
+        style[i] = cell_style_bits;
+        glyph_uv[i] = glyph.uv;
+        glyph_box[i] = glyph.box;
+        glyph_layer[i] = glyph.layer;
+    }
 }
 
 void main(){
-    vec2 pos = (vec2(0, gl_WorkGroupID.x) + (4*gl_LocalInvocationID.xy)) * grid_size + vec2(-1.0, -1.0);
-    uvec4 char_4_indices = tex_indices.indices[gl_GlobalInvocationID.x];
-    uint char_indices[4] = {char_4_indices.x,char_4_indices.y,char_4_indices.z,char_4_indices.w};
-    for (int i = 0; i < 4; i++){
-        draw_char(char_indices[i], pos+vec2(grid_width*i,0),   gl_LocalInvocationID.x*4*2+i*2,   gl_LocalInvocationID.x*6*4+i*6);
+    const vec2 grid_size = vec2(2.0) / vec2(pane.width, pane.visible_height);
+    uint meshlet = payload.meshlets[gl_WorkGroupID.x];
+    uint row = meshlet >> 16;
+    uint first_word = (meshlet & 0xffffu) * meshlet_words;
+    uint cell_count = 0;
+    for (uint i = 0; i < meshlet_words; i++) {
+        cell_count += bitCount(occupancy_word(row, first_word + i, pane.width));
     }
+    SetMeshOutputsEXT(cell_count*4, cell_count*2);
 
-    SetMeshOutputsEXT(width*height*2*3, width*height*2);
+    // blank cells emit nothing, the visible ones are compacted to the front of the outputs.
+    for (uint column_in_meshlet = gl_LocalInvocationID.x; column_in_meshlet < meshlet_cells; column_in_meshlet += gl_WorkGroupSize.x) {
+        uint word_in_meshlet = column_in_meshlet / occupancy_word_cells;
+        uint bit = column_in_meshlet % occupancy_word_cells;
+        uint mask = occupancy_word(row, first_word + word_in_meshlet, pane.width);
+        if ((mask & (1u << bit)) != 0u) {
+            uint slot = bitCount(mask & ((1u << bit) - 1u));
+            for (uint i = 0; i < word_in_meshlet; i++) {
+                slot += bitCount(occupancy_word(row, first_word + i, pane.width));
+            }
+            uint column = first_word*occupancy_word_cells + column_in_meshlet;
+            uvec3 cell = load_packed_cell(cells, pane.cell_offset + row*pane.width + column);
+            vec2 pos = (vec2(column, row) - pane.scroll_offset) * grid_size + vec2(-1.0, -1.0);
+            draw_char(cell, pos, grid_size, slot);
+        }
+    }
 }
@@ -1,79 +1,182 @@
 #pragma once
 
-template<class T, size_t Dim0_size, size_t Dim1_size, size_t Dim = 2>
-class multidimention_array {
-    static_assert(Dim == 2);
+#include <array>
+#include <cassert>
+#include <compare>
+#include <cstddef>
+#include <iterator>
+#include <span>
+#include <utility>
+#include <vector>
+
+// Walks a strided 2D window row by row, only the step past a row end moves to the next row.
+template<class T>
+class strided_iterator {
 public:
-    struct elem_ref {
-        using difference_type = int;
-        using value_type = T;
-        using pointer = T*;
-        using reference = T&;
-        using iterator_category = std::random_access_iterator_tag;
-        using iterator_concept = std::contiguous_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = std::remove_const_t<T>;
+    using pointer = T*;
+    using reference = T&;
+    using iterator_category = std::random_access_iterator_tag;
+    using iterator_concept = std::random_access_iterator_tag;
 
-        auto& operator=(const elem_ref& rhs) {
-            m_array = rhs.m_array;
-            x = rhs.x;
-            y = rhs.y;
-            return *this;
-        }
-        auto& operator++() {
-            if (x + 1 == Dim0_size) {
-                x = 0;
-                ++y;
-            }
-            else {
-                ++x;
-            }
-            return *this;
-        }
-        auto operator++(int) {
-            auto ret = *this;
-            ++*this;
-            return ret;
-        }
-        auto& operator--() {
-            if (x == 0) {
-                x = Dim0_size - 1;
-                --y;
-            }
-            else {
-                --x;
-            }
-            return *this;
-        }
-        auto operator--(int) {
-            auto ret = *this;
-            --*this;
-            return ret;
-        }
-        auto& operator*() {
-            return m_array[std::pair{ x, y }];
-        }
-        auto operator+(const int i) const {
-            elem_ref res{ m_array, x,y };
-            res.x += i;
-            res.y += res.x / Dim0_size;
-            res.x %= Dim0_size;
-            return res;
-        }
-        auto operator-(const elem_ref& rhs) const{
-            return (rhs.y - y) * Dim1_size + rhs.x - x;
+    strided_iterator() : m_ptr{}, m_x{}, m_y{}, m_width{ 1 }, m_stride{ 1 } {}
+    strided_iterator(T* ptr, size_t x, size_t y, size_t width, size_t stride)
+        : m_ptr{ ptr }, m_x{ x }, m_y{ y }, m_width{ width }, m_stride{ stride } {}
+
+    reference operator*() const {
+        return *m_ptr;
+    }
+    pointer operator->() const {
+        return m_ptr;
+    }
+    reference operator[](difference_type i) const {
+        return *(*this + i);
+    }
+    auto& operator++() {
+        ++m_ptr;
+        if (++m_x == m_width) {
+            m_ptr += m_stride - m_width;
+            m_x = 0;
+            ++m_y;
         }
-        bool operator==(elem_ref rhs) const {
-            return x == rhs.x && y == rhs.y;
+        return *this;
+    }
+    auto operator++(int) {
+        auto ret = *this;
+        ++*this;
+        return ret;
+    }
+    auto& operator--() {
+        if (m_x == 0) {
+            m_ptr -= m_stride - m_width;
+            m_x = m_width;
+            --m_y;
         }
-        multidimention_array& m_array;
-        int x;
-        int y;
-    };
+        --m_ptr;
+        --m_x;
+        return *this;
+    }
+    auto operator--(int) {
+        auto ret = *this;
+        --*this;
+        return ret;
+    }
+    auto& operator+=(difference_type i) {
+        auto index = get_index() + i;
+        auto x = static_cast<size_t>(index) % m_width;
+        auto y = static_cast<size_t>(index) / m_width;
+        m_ptr += (static_cast<difference_type>(y) - static_cast<difference_type>(m_y)) * static_cast<difference_type>(m_stride)
+            + static_cast<difference_type>(x) - static_cast<difference_type>(m_x);
+        m_x = x;
+        m_y = y;
+        return *this;
+    }
+    auto& operator-=(difference_type i) {
+        return *this += -i;
+    }
+    friend auto operator+(strided_iterator ite, difference_type i) {
+        return ite += i;
+    }
+    friend auto operator+(difference_type i, strided_iterator ite) {
+        return ite += i;
+    }
+    friend auto operator-(strided_iterator ite, difference_type i) {
+        return ite -= i;
+    }
+    friend difference_type operator-(const strided_iterator& lhs, const strided_iterator& rhs) {
+        return lhs.get_index() - rhs.get_index();
+    }
+    friend bool operator==(const strided_iterator& lhs, const strided_iterator& rhs) {
+        return lhs.m_x == rhs.m_x && lhs.m_y == rhs.m_y;
+    }
+    friend auto operator<=>(const strided_iterator& lhs, const strided_iterator& rhs) {
+        return lhs.get_index() <=> rhs.get_index();
+    }
+private:
+    difference_type get_index() const {
+        return static_cast<difference_type>(m_y * m_width + m_x);
+    }
+    T* m_ptr;
+    size_t m_x;
+    size_t m_y;
+    size_t m_width;
+    size_t m_stride;
+};
+
+// Non owning 2D window into row major storage whose rows are stride elements apart,
+// a sub view of a bigger grid needs no copy.
+template<class T>
+class multidimention_view {
+public:
+    using value_type = std::remove_const_t<T>;
+    multidimention_view() : multidimention_view(nullptr, 0, 0, 0) {}
+    multidimention_view(T* data, size_t width, size_t height, size_t stride)
+        : m_data{ data }, m_width{ width }, m_height{ height }, m_stride{ stride } {
+        assert(stride >= width);
+    }
+    auto begin() const {
+        return strided_iterator<T>{ m_data, 0, 0, get_iterator_width(), m_stride };
+    }
+    auto end() const {
+        return strided_iterator<T>{ m_data + m_height * m_stride, 0, m_width == 0 ? 0 : m_height, get_iterator_width(), m_stride };
+    }
+    auto size() const {
+        return m_width * m_height;
+    }
+    auto get_width() const {
+        return m_width;
+    }
+    auto get_height() const {
+        return m_height;
+    }
+    auto get_stride() const {
+        return m_stride;
+    }
+    auto data() const {
+        return m_data;
+    }
+    std::span<T> get_row(size_t y) const {
+        assert(y < m_height);
+        return std::span<T>{ m_data + y * m_stride, m_width };
+    }
+    bool is_contiguous() const {
+        return m_stride == m_width || m_height <= 1;
+    }
+    // the whole window as one span, only if no row has padding after it.
+    std::span<T> get_span() const {
+        assert(is_contiguous());
+        return std::span<T>{ m_data, size() };
+    }
+    auto get_subview(size_t x, size_t y, size_t width, size_t height) const {
+        assert(x + width <= m_width && y + height <= m_height);
+        return multidimention_view<T>{ m_data + y * m_stride + x, width, height, m_stride };
+    }
+    T& operator[](std::pair<size_t, size_t> index) const {
+        auto [x, y] = index;
+        assert(x < m_width && y < m_height);
+        return m_data[y * m_stride + x];
+    }
+private:
+    size_t get_iterator_width() const {
+        return m_width == 0 ? 1 : m_width;
+    }
+    T* m_data;
+    size_t m_width;
+    size_t m_height;
+    size_t m_stride;
+};
+
+template<class T, size_t Dim0_size, size_t Dim1_size, size_t Dim = 2>
+class multidimention_array {
+    static_assert(Dim == 2);
+public:
     using value_type = T;
     auto begin() {
-        return elem_ref{ *this, 0, 0 };
+        return get_view().begin();
     }
     auto end() {
-        return elem_ref{ *this, 0, Dim1_size };
+        return get_view().end();
     }
     auto size() const {
         return Dim0_size * Dim1_size;
@@ -84,6 +187,15 @@ public:
     constexpr auto get_dim1_size() const {
         return Dim1_size;
     }
+    auto get_view() {
+        return multidimention_view<T>{ m_data[0].data(), Dim0_size, Dim1_size, Dim0_size };
+    }
+    std::span<T, Dim0_size> get_row(size_t y) {
+        return m_data[y];
+    }
+    std::span<T> get_span() {
+        return std::span<T>{ m_data[0].data(), size() };
+    }
     T& operator[](std::pair<int, int> index) {
         auto [x, y] = index;
         return m_data[y][x];
@@ -99,81 +211,28 @@ public:
     multidimention_vector() :
         multidimention_vector(0, 0) {}
     multidimention_vector(size_t width, size_t height) :
+        multidimention_vector(width, height, width) {}
+    // rows are stride elements apart, the padding after each row is not part of the grid.
+    multidimention_vector(size_t width, size_t height, size_t stride) :
+        m_data(stride*height),
         m_width{ width },
-        m_stride{ width },
-        m_height{ height },
-        m_data(width*height)
-    {}
-    struct elem_ref {
-        using difference_type = int;
-        using value_type = T;
-        using pointer = T*;
-        using reference = T&;
-        using iterator_category = std::random_access_iterator_tag;
-        using iterator_concept = std::contiguous_iterator_tag;
-
-        auto& operator=(const elem_ref& rhs) {
-            m_array = rhs.m_array;
-            x = rhs.x;
-            y = rhs.y;
-            return *this;
-        }
-        auto& operator++() {
-            if (x + 1 == m_array.m_width) {
-                x = 0;
-                ++y;
-            }
-            else {
-                ++x;
-            }
-            return *this;
-        }
-        auto operator++(int) {
-            auto ret = *this;
-            ++*this;
-            return ret;
-        }
-        auto& operator--() {
-            if (x == 0) {
-                x = m_array.m_width - 1;
-                --y;
-            }
-            else {
-                --x;
-            }
-            return *this;
-        }
-        auto operator--(int) {
-            auto ret = *this;
-            --*this;
-            return ret;
-        }
-        auto& operator*() {
-            return m_array[std::pair{ x, y }];
-        }
-        auto operator+(const int i) const {
-            elem_ref res{ m_array, x,y };
-            res.x += i;
-            res.y += res.x / m_array.m_width;
-            res.x %= m_array.m_width;
-            return res;
-        }
-        auto operator-(const elem_ref& rhs) const {
-            return (rhs.y - y) * m_array.m_width+ rhs.x - x;
-        }
-        bool operator==(elem_ref rhs) const {
-            return x == rhs.x && y == rhs.y;
-        }
-        multidimention_vector& m_array;
-        size_t x;
-        size_t y;
-    };
+        m_stride{ stride },
+        m_height{ height }
+    {
+        assert(stride >= width);
+    }
     using value_type = T;
     auto begin() {
-        return elem_ref{ *this, 0, 0 };
+        return get_view().begin();
     }
     auto end() {
-        return elem_ref{ *this, 0, m_height };
+        return get_view().end();
+    }
+    auto begin() const {
+        return get_view().begin();
+    }
+    auto end() const {
+        return get_view().end();
     }
     auto size() const {
         return m_width * m_height;
@@ -190,7 +249,35 @@ public:
     constexpr auto get_height() const {
         return m_height;
     }
-    size_t get_linear_index(std::pair<size_t, size_t> index) {
+    constexpr auto get_stride() const {
+        return m_stride;
+    }
+    auto get_view() {
+        return multidimention_view<T>{ m_data.data(), m_width, m_height, m_stride };
+    }
+    auto get_view() const {
+        return multidimention_view<const T>{ m_data.data(), m_width, m_height, m_stride };
+    }
+    auto get_subview(size_t x, size_t y, size_t width, size_t height) {
+        return get_view().get_subview(x, y, width, height);
+    }
+    std::span<T> get_row(size_t y) {
+        return get_view().get_row(y);
+    }
+    std::span<const T> get_row(size_t y) const {
+        return get_view().get_row(y);
+    }
+    bool is_contiguous() const {
+        return get_view().is_contiguous();
+    }
+    std::span<T> get_span() {
+        return get_view().get_span();
+    }
+    std::span<const T> get_span() const {
+        return get_view().get_span();
+    }
+    // index in a dense width x height copy of the grid, like the packed cells of a pane.
+    size_t get_linear_index(std::pair<size_t, size_t> index) const {
         auto [x, y] = index;
         assert(x < m_width && y < m_height);
         return y * m_width + x;
@@ -200,6 +287,11 @@ public:
         assert(x < m_width && y < m_height);
         return m_data[y*m_stride + x];
     }
+    const T& operator[](std::pair<size_t, size_t> index) const {
+        auto [x, y] = index;
+        assert(x < m_width && y < m_height);
+        return m_data[y*m_stride + x];
+    }
 private:
     std::vector<T> m_data;
     size_t m_width;
@@ -0,0 +1,10 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+
+#include "overlay_parameters.glsl"
+
+layout(location=0) out vec4 out_color;
+
+void main() {
+    out_color = overlay.color;
+}
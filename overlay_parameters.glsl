@@ -0,0 +1,6 @@
+// overlay_push_constants from vulkan_renderer.hpp, one rectangle of the cursor or selection overlay.
+layout(push_constant) uniform overlay_parameters {
+    // left, top, right, bottom in normalized device coordinates of the pane viewport.
+    vec4 rect;
+    vec4 color;
+} overlay;
@@ -0,0 +1,10 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+
+#include "overlay_parameters.glsl"
+
+const vec2 corners[6] = vec2[](vec2(0,0), vec2(1,0), vec2(0,1), vec2(0,1), vec2(1,0), vec2(1,1));
+
+void main() {
+    gl_Position = vec4(mix(overlay.rect.xy, overlay.rect.zw, corners[gl_VertexIndex]), 0, 1);
+}
@@ -0,0 +1,23 @@
+// decoding of packed_cell from terminal_cell.hpp, a cell is uvec3(glyph, foreground, background).
+// the cells buffer is a uint array, a uvec3 array would have a 16 byte stride in std430.
+#define load_packed_cell(cells, index) uvec3(cells[(index)*3u], cells[(index)*3u + 1u], cells[(index)*3u + 2u])
+const uint cell_style_foreground_palette = 1;
+const uint cell_style_background_palette = 2;
+const uint cell_style_underline = 4;
+const uint cell_style_strikethrough = 8;
+
+uint cell_glyph_index(uvec3 cell) {
+    return cell.x;
+}
+uint cell_style(uvec3 cell) {
+    return (cell.y >> 24) & 0xfu;
+}
+uint cell_foreground(uvec3 cell) {
+    return cell.y & 0xffffffu;
+}
+uint cell_background(uvec3 cell) {
+    return cell.z;
+}
+vec3 unpack_rgb(uint color) {
+    return vec3((color >> 16) & 0xffu, (color >> 8) & 0xffu, color & 0xffu) / 255.0;
+}
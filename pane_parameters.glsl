@@ -0,0 +1,11 @@
+// pane_push_constants from vulkan_renderer.hpp, the pane's cells start at cell_offset in the cells buffer.
+layout(push_constant) uniform pane_parameters {
+    uint cell_offset;
+    uint width;
+    uint height;
+    uint occupancy_offset;
+    // sub-cell scroll in cells, the grid is drawn shifted up and left by it.
+    vec2 scroll_offset;
+    // rows that fill the viewport, height has a guard row more while smooth scrolling.
+    uint visible_height;
+} pane;
@@ -0,0 +1,266 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "terminal_cell.hpp"
+#include "multidimention_array.hpp"
+#include "spill_file.hpp"
+
+// Compressed page of page_lines scrollback lines. Each row is stored either as a reference to an
+// identical earlier row of the page, or as its literal cells followed by one cell that repeats to
+// the end of the row, which takes care of blank tails.
+//   row:  uint32_t ref_or_literal_count, [uint32_t width, literal cells, tail cell]
+//   cell: uint32_t character, foreground, background, style, a color is its value with the palette bit on top.
+class scrollback_page {
+public:
+    static constexpr uint32_t row_ref_bit = 0x80000000;
+
+    static scrollback_page compress(const std::vector<std::vector<terminal_cell>>& rows) {
+        scrollback_page page{};
+        std::unordered_map<uint64_t, std::vector<uint32_t>> rows_by_hash;
+        for (uint32_t y = 0; y < rows.size(); y++) {
+            auto& row = rows[y];
+            auto& same_hash_rows = rows_by_hash[hash_row(row)];
+            auto same_row = std::ranges::find_if(same_hash_rows, [&rows, &row](auto i) { return rows[i] == row; });
+            page.m_row_offsets.push_back(static_cast<uint32_t>(page.m_data.size()));
+            if (same_row != same_hash_rows.end()) {
+                page.append(row_ref_bit | *same_row);
+                continue;
+            }
+            same_hash_rows.push_back(y);
+            uint32_t literal_count = static_cast<uint32_t>(row.size());
+            while (literal_count > 0 && row[literal_count - 1] == row.back()) {
+                literal_count--;
+            }
+            page.append(literal_count);
+            page.append(static_cast<uint32_t>(row.size()));
+            for (uint32_t x = 0; x < literal_count; x++) {
+                page.append_cell(row[x]);
+            }
+            page.append_cell(row.empty() ? terminal_cell{} : row.back());
+        }
+        page.m_data.shrink_to_fit();
+        return page;
+    }
+    // writes the row into out, cells past the stored width are set to fill.
+    // a spilled page reads straight from the mapping of the spill file.
+    void decompress_row(uint32_t y, std::span<terminal_cell> out, const terminal_cell& fill, const spill_file* file) const {
+        auto data = get_data(file);
+        auto offset = m_row_offsets[y];
+        auto header = read<uint32_t>(data, offset);
+        if (header & row_ref_bit) {
+            offset = m_row_offsets[header & ~row_ref_bit];
+            header = read<uint32_t>(data, offset);
+        }
+        auto literal_count = header;
+        auto width = read<uint32_t>(data, offset + sizeof(uint32_t));
+        auto cells_offset = offset + 2 * sizeof(uint32_t);
+        auto copy_count = std::min<size_t>(literal_count, out.size());
+        for (size_t x = 0; x < copy_count; x++) {
+            out[x] = read_cell(data, cells_offset + x * cell_size);
+        }
+        auto tail_end = std::min<size_t>(width, out.size());
+        if (copy_count < tail_end) {
+            std::ranges::fill(out.subspan(copy_count, tail_end - copy_count),
+                read_cell(data, cells_offset + literal_count * cell_size));
+        }
+        if (tail_end < out.size()) {
+            std::ranges::fill(out.subspan(tail_end), fill);
+        }
+    }
+    size_t get_line_count() const {
+        return m_row_offsets.size();
+    }
+    // the row offsets stay in memory when the page is spilled.
+    size_t get_memory_usage() const {
+        return m_data.capacity() + m_row_offsets.capacity() * sizeof(uint32_t);
+    }
+    size_t get_data_size() const {
+        return m_spill_location ? m_spill_location->size : m_data.size();
+    }
+    std::span<const std::byte> get_data(const spill_file* file) const {
+        if (m_spill_location) {
+            return file->read(m_spill_location->offset, m_spill_location->size);
+        }
+        return m_data;
+    }
+    bool is_spilled() const {
+        return m_spill_location.has_value();
+    }
+    void spill(spill_file& file) {
+        assert(!is_spilled());
+        m_spill_location = spill_location{ file.append(m_data), m_data.size() };
+        m_data = std::vector<std::byte>{};
+    }
+private:
+    static uint64_t hash_row(const std::vector<terminal_cell>& row) {
+        uint64_t hash = 14695981039346656037ull;
+        for (auto& cell : row) {
+            for (auto value : { cell.character, cell.foreground.get_value(), cell.background.get_value(), cell.style }) {
+                hash = (hash ^ value) * 1099511628211ull;
+            }
+        }
+        return hash;
+    }
+    // the fields one by one, terminal_cell has padding that must not end up in the page.
+    static constexpr size_t cell_size = 4 * sizeof(uint32_t);
+    static constexpr uint32_t palette_bit = 0x80000000;
+    static uint32_t encode_color(cell_color color) {
+        return color.get_value() | (color.is_palette() ? palette_bit : 0);
+    }
+    static cell_color decode_color(uint32_t value) {
+        return (value & palette_bit) ? cell_color::palette(static_cast<uint8_t>(value))
+            : cell_color::rgb(static_cast<uint8_t>(value >> 16), static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value));
+    }
+    void append_cell(const terminal_cell& cell) {
+        append(cell.character);
+        append(encode_color(cell.foreground));
+        append(encode_color(cell.background));
+        append(cell.style);
+    }
+    static terminal_cell read_cell(std::span<const std::byte> data, size_t offset) {
+        return terminal_cell{
+            read<uint32_t>(data, offset),
+            decode_color(read<uint32_t>(data, offset + sizeof(uint32_t))),
+            decode_color(read<uint32_t>(data, offset + 2 * sizeof(uint32_t))),
+            read<uint32_t>(data, offset + 3 * sizeof(uint32_t)) };
+    }
+    template<class T>
+    void append(const T& value) {
+        auto offset = m_data.size();
+        m_data.resize(offset + sizeof(T));
+        std::memcpy(m_data.data() + offset, &value, sizeof(T));
+    }
+    template<class T>
+    static T read(std::span<const std::byte> data, size_t offset) {
+        T value;
+        std::memcpy(&value, data.data() + offset, sizeof(T));
+        return value;
+    }
+    struct spill_location {
+        size_t offset;
+        size_t size;
+    };
+    std::vector<std::byte> m_data;
+    std::vector<uint32_t> m_row_offsets;
+    std::optional<spill_location> m_spill_location;
+};
+
+// Lines that scrolled off the top of a terminal. The newest page is kept uncompressed while it fills,
+// older pages are compressed. Once the resident compressed pages exceed the memory cap the oldest
+// ones are written to the spill file if there is one, or dropped otherwise.
+// On top of the cap there is at most one uncompressed page and the row offsets of spilled pages.
+class scrollback_store {
+public:
+    static constexpr size_t page_lines = 256;
+    static constexpr size_t default_memory_cap = 64 * 1024 * 1024;
+
+    // spill_directory is where the nameless spill file is created, it is ignored where spill_file is not supported.
+    scrollback_store(size_t memory_cap = default_memory_cap, std::optional<std::filesystem::path> spill_directory = {})
+        : m_memory_cap{ memory_cap }, m_compressed_memory_usage{}, m_dropped_line_count{},
+        m_first_resident_page{}, m_spilled_bytes{}, m_spilled_index_memory_usage{} {
+        if (spill_directory && spill_file::is_supported) {
+            m_spill_file = std::make_unique<spill_file>(*spill_directory);
+        }
+    }
+
+    void push_line(std::span<const terminal_cell> line) {
+        m_hot_rows.emplace_back(line.begin(), line.end());
+        if (m_hot_rows.size() == page_lines) {
+            m_pages.push_back(scrollback_page::compress(m_hot_rows));
+            m_compressed_memory_usage += m_pages.back().get_memory_usage();
+            m_hot_rows.clear();
+            enforce_memory_cap();
+        }
+    }
+    // line 0 is the oldest line still kept.
+    size_t get_line_count() const {
+        return m_pages.size() * page_lines + m_hot_rows.size();
+    }
+    // lines dropped from the front because of the memory cap.
+    size_t get_dropped_line_count() const {
+        return m_dropped_line_count;
+    }
+    size_t get_memory_usage() const {
+        size_t hot_memory_usage = 0;
+        for (auto& row : m_hot_rows) {
+            hot_memory_usage += row.capacity() * sizeof(terminal_cell);
+        }
+        return m_compressed_memory_usage + m_spilled_index_memory_usage + hot_memory_usage;
+    }
+    // compressed page bytes held in memory.
+    size_t get_resident_bytes() const {
+        return m_compressed_memory_usage;
+    }
+    // compressed page bytes written to the spill file.
+    size_t get_spilled_bytes() const {
+        return m_spilled_bytes;
+    }
+    void set_memory_cap(size_t memory_cap) {
+        m_memory_cap = memory_cap;
+        enforce_memory_cap();
+    }
+    void copy_line(size_t line, std::span<terminal_cell> out, const terminal_cell& fill = terminal_cell{}) const {
+        assert(line < get_line_count());
+        auto page_index = line / page_lines;
+        if (page_index < m_pages.size()) {
+            m_pages[page_index].decompress_row(static_cast<uint32_t>(line % page_lines), out, fill, m_spill_file.get());
+            return;
+        }
+        auto& row = m_hot_rows[line - m_pages.size() * page_lines];
+        auto copy_count = std::min(row.size(), out.size());
+        std::ranges::copy(std::span{ row }.first(copy_count), out.begin());
+        std::ranges::fill(out.subspan(copy_count), fill);
+    }
+    // fills the view with lines first_line.. , each row costs one page lookup and one row decode.
+    // rows past the last stored line are set to fill.
+    void map_window(size_t first_line, multidimention_view<terminal_cell> view, const terminal_cell& fill = terminal_cell{}) const {
+        for (size_t y = 0; y < view.get_height(); y++) {
+            if (first_line + y < get_line_count()) {
+                copy_line(first_line + y, view.get_row(y), fill);
+            }
+            else {
+                std::ranges::fill(view.get_row(y), fill);
+            }
+        }
+    }
+private:
+    void enforce_memory_cap() {
+        while (m_first_resident_page < m_pages.size() && m_compressed_memory_usage > m_memory_cap) {
+            if (m_spill_file) {
+                auto& page = m_pages[m_first_resident_page++];
+                auto memory_usage = page.get_memory_usage();
+                page.spill(*m_spill_file);
+                m_compressed_memory_usage -= memory_usage;
+                m_spilled_index_memory_usage += page.get_memory_usage();
+                m_spilled_bytes += page.get_data_size();
+            }
+            else {
+                m_compressed_memory_usage -= m_pages.front().get_memory_usage();
+                m_pages.pop_front();
+                m_dropped_line_count += page_lines;
+            }
+        }
+    }
+    size_t m_memory_cap;
+    std::deque<scrollback_page> m_pages;
+    std::vector<std::vector<terminal_cell>> m_hot_rows;
+    size_t m_compressed_memory_usage;
+    size_t m_dropped_line_count;
+    std::unique_ptr<spill_file> m_spill_file;
+    // pages before it are spilled, the ones after it are in memory.
+    size_t m_first_resident_page;
+    size_t m_spilled_bytes;
+    size_t m_spilled_index_memory_usage;
+};
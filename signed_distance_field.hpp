@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <thread>
+#include <vector>
+
+// Exact squared euclidean distance transform of one line, Felzenszwalb and Huttenlocher.
+// f holds 0 on feature pixels and far_distance elsewhere, d receives the squared distances.
+constexpr float far_distance = 1e20f;
+inline void squared_distance_transform_1d(std::span<const float> f, std::span<float> d,
+    std::vector<size_t>& v, std::vector<float>& z) {
+    auto n = f.size();
+    v.resize(n);
+    z.resize(n + 1);
+    auto intersection = [&f](size_t q, size_t p) {
+        return ((f[q] + static_cast<float>(q * q)) - (f[p] + static_cast<float>(p * p))) / (2.0f * q - 2.0f * p);
+    };
+    size_t k = 0;
+    v[0] = 0;
+    z[0] = -far_distance;
+    z[1] = far_distance;
+    for (size_t q = 1; q < n; q++) {
+        auto s = intersection(q, v[k]);
+        while (s <= z[k]) {
+            k--;
+            s = intersection(q, v[k]);
+        }
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = far_distance;
+    }
+    k = 0;
+    for (size_t q = 0; q < n; q++) {
+        while (z[k + 1] < q) {
+            k++;
+        }
+        float dq = static_cast<float>(q) - static_cast<float>(v[k]);
+        d[q] = dq * dq + f[v[k]];
+    }
+}
+
+// squared distance of every pixel to the nearest pixel where feature is true.
+inline std::vector<float> squared_distance_transform(const std::vector<bool>& feature, size_t width, size_t height) {
+    std::vector<float> grid(width * height);
+    for (size_t i = 0; i < grid.size(); i++) {
+        grid[i] = feature[i] ? 0.0f : far_distance;
+    }
+    std::vector<float> f(std::max(width, height));
+    std::vector<float> d(std::max(width, height));
+    std::vector<size_t> v;
+    std::vector<float> z;
+    for (size_t x = 0; x < width; x++) {
+        for (size_t y = 0; y < height; y++) {
+            f[y] = grid[y * width + x];
+        }
+        squared_distance_transform_1d(std::span{ f }.first(height), std::span{ d }.first(height), v, z);
+        for (size_t y = 0; y < height; y++) {
+            grid[y * width + x] = d[y];
+        }
+    }
+    for (size_t y = 0; y < height; y++) {
+        auto row = std::span{ grid }.subspan(y * width, width);
+        std::ranges::copy(row, f.begin());
+        squared_distance_transform_1d(std::span{ f }.first(width), row, v, z);
+    }
+    return grid;
+}
+
+// Replaces an 8 bit coverage tile with its signed distance field: 0.5 on the outline,
+// spread pixels outside the outline reach 0 and spread pixels inside reach 1.
+inline void coverage_to_signed_distance_field(unsigned char* ptr, size_t width, size_t height, size_t pitch, float spread) {
+    std::vector<bool> inside(width * height);
+    for (size_t y = 0; y < height; y++) {
+        for (size_t x = 0; x < width; x++) {
+            inside[y * width + x] = ptr[y * pitch + x] >= 128;
+        }
+    }
+    auto distance_to_inside = squared_distance_transform(inside, width, height);
+    inside.flip();
+    auto distance_to_outside = squared_distance_transform(inside, width, height);
+    for (size_t y = 0; y < height; y++) {
+        for (size_t x = 0; x < width; x++) {
+            auto i = y * width + x;
+            // distances are measured between pixel centers, the outline lies half a pixel in between.
+            float distance = distance_to_outside[i] > 0
+                ? std::sqrt(distance_to_outside[i]) - 0.5f
+                : 0.5f - std::sqrt(distance_to_inside[i]);
+            float value = std::clamp(0.5f + distance / (2 * spread), 0.0f, 1.0f);
+            ptr[y * pitch + x] = static_cast<unsigned char>(std::lround(value * 255));
+        }
+    }
+}
+
+// converts tile_count tiles laid out columns per row, tiles are independent so they are split between threads.
+inline void tiles_to_signed_distance_field(unsigned char* ptr, size_t pitch,
+    size_t tile_width, size_t tile_height, size_t tile_count, size_t columns, float spread) {
+    size_t thread_count = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, std::max<size_t>(tile_count, 1));
+    std::vector<std::jthread> threads;
+    for (size_t t = 0; t < thread_count; t++) {
+        threads.emplace_back([=]() {
+            std::vector<unsigned char> tile(tile_width * tile_height);
+            for (size_t i = t; i < tile_count; i += thread_count) {
+                auto tile_ptr = ptr + (i / columns) * tile_height * pitch + (i % columns) * tile_width;
+                // works on a local copy, the atlas memory may be uncached.
+                for (size_t y = 0; y < tile_height; y++) {
+                    std::copy_n(tile_ptr + y * pitch, tile_width, tile.data() + y * tile_width);
+                }
+                coverage_to_signed_distance_field(tile.data(), tile_width, tile_height, tile_width, spread);
+                for (size_t y = 0; y < tile_height; y++) {
+                    std::copy_n(tile.data() + y * tile_width, tile_width, tile_ptr + y * pitch);
+                }
+            }
+            });
+    }
+}
@@ -0,0 +1,487 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <set>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SOFTWARE_RENDERER_SSE2
+#endif
+
+#ifdef __unix__
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "terminal_cell.hpp"
+#include "multidimention_array.hpp"
+#include "glyph_packer.hpp"
+#include "run_result.hpp"
+
+// Leads the pixels of a software_framebuffer. frame is a sequence lock, odd while a frame is painted and
+// even again after it. A reader of the shared memory file takes the pixels it copied only if frame was even
+// before the copy and unchanged after it, like copy_frame does.
+struct software_framebuffer_header {
+    uint32_t magic;
+    uint32_t width;
+    uint32_t height;
+    uint32_t frame;
+};
+
+// RGBA8 pixels, in memory or in a file mapped with MAP_SHARED so other processes can read the frames,
+// a path under /dev/shm keeps it out of the disk. Without mmap support the pixels are kept in memory.
+class software_framebuffer {
+public:
+    static constexpr uint32_t magic = 0x42475254;
+
+    software_framebuffer(uint32_t width, uint32_t height, std::optional<std::filesystem::path> path = {})
+        : m_width{ width }, m_height{ height } {
+        auto size = get_mapping_size();
+#ifdef __unix__
+        if (path) {
+            m_file_descriptor = open(path->c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+            if (m_file_descriptor == -1) {
+                throw std::runtime_error{ "failed to open framebuffer file" };
+            }
+            if (ftruncate(m_file_descriptor, size) == -1) {
+                close(m_file_descriptor);
+                throw std::runtime_error{ "failed to size framebuffer file" };
+            }
+            mmaped_ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_file_descriptor, 0);
+            if (mmaped_ptr == MAP_FAILED) {
+                close(m_file_descriptor);
+                throw std::runtime_error{ "failed to map framebuffer file" };
+            }
+        }
+        else {
+            m_file_descriptor = -1;
+            mmaped_ptr = nullptr;
+        }
+#endif
+        if (get_mapping() == nullptr) {
+            m_data.resize((size + sizeof(uint32_t) - 1) / sizeof(uint32_t));
+        }
+        *get_header() = software_framebuffer_header{ magic, width, height, 0 };
+    }
+    software_framebuffer(const software_framebuffer& framebuffer) = delete;
+    software_framebuffer(software_framebuffer&& framebuffer) = delete;
+    ~software_framebuffer() {
+#ifdef __unix__
+        if (mmaped_ptr != nullptr) {
+            munmap(mmaped_ptr, get_mapping_size());
+            close(m_file_descriptor);
+        }
+#endif
+    }
+    software_framebuffer& operator=(const software_framebuffer& framebuffer) = delete;
+    software_framebuffer& operator=(software_framebuffer&& framebuffer) = delete;
+
+    uint32_t get_width() const {
+        return m_width;
+    }
+    uint32_t get_height() const {
+        return m_height;
+    }
+    // one uint32_t per pixel, bytes in r, g, b, a order.
+    std::span<uint32_t> get_pixels() {
+        return std::span<uint32_t>{ reinterpret_cast<uint32_t*>(get_header() + 1), size_t{ m_width } * m_height };
+    }
+    std::span<const uint32_t> get_pixels() const {
+        return const_cast<software_framebuffer*>(this)->get_pixels();
+    }
+    std::span<uint32_t> get_row(uint32_t y) {
+        return get_pixels().subspan(size_t{ y } * m_width, m_width);
+    }
+    uint32_t get_frame() const {
+        return get_frame_ref().load(std::memory_order_acquire);
+    }
+    // the pixels may be written between begin_frame and end_frame only.
+    void begin_frame() {
+        auto frame = get_frame_ref();
+        frame.store(frame.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+    void end_frame() {
+        auto frame = get_frame_ref();
+        frame.store(frame.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    // the reader side, false if a frame was being painted during the copy, a torn copy is never returned as valid.
+    bool copy_frame(std::span<uint32_t> pixels, uint32_t& frame) const {
+        auto source = get_pixels();
+        assert(pixels.size() == source.size());
+        auto before = get_frame();
+        if (before % 2 != 0) {
+            return false;
+        }
+        for (size_t i = 0; i < source.size(); i++) {
+            pixels[i] = std::atomic_ref<uint32_t>{ const_cast<uint32_t&>(source[i]) }.load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        frame = before;
+        return get_frame_ref().load(std::memory_order_relaxed) == before;
+    }
+private:
+    size_t get_mapping_size() const {
+        return sizeof(software_framebuffer_header) + size_t{ m_width } * m_height * sizeof(uint32_t);
+    }
+    void* get_mapping() {
+#ifdef __unix__
+        if (mmaped_ptr != nullptr) {
+            return mmaped_ptr;
+        }
+#endif
+        return m_data.empty() ? nullptr : m_data.data();
+    }
+    software_framebuffer_header* get_header() {
+        return static_cast<software_framebuffer_header*>(get_mapping());
+    }
+    std::atomic_ref<uint32_t> get_frame_ref() const {
+        return std::atomic_ref<uint32_t>{ const_cast<software_framebuffer*>(this)->get_header()->frame };
+    }
+    uint32_t m_width;
+    uint32_t m_height;
+#ifdef __unix__
+    int m_file_descriptor;
+    void* mmaped_ptr;
+#endif
+    std::vector<uint32_t> m_data;
+};
+
+inline uint32_t pack_rgba8(const std::array<float, 4>& color) {
+    auto to_byte = [](float v) { return static_cast<uint8_t>(std::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f); };
+    return std::bit_cast<uint32_t>(std::array<uint8_t, 4>{ to_byte(color[0]), to_byte(color[1]), to_byte(color[2]), to_byte(color[3]) });
+}
+
+// out[i] = mix(background, foreground, coverage) per channel, coverage is sampled from glyph_row at tex_x[i].
+// the SSE2 path blends 4 pixels per step with the same rounding as the scalar tail.
+inline void blend_glyph_span(uint32_t* out, const unsigned char* glyph_row, const uint16_t* tex_x, size_t count,
+    uint32_t foreground, uint32_t background) {
+    size_t i = 0;
+#ifdef SOFTWARE_RENDERER_SSE2
+    const auto zero = _mm_setzero_si128();
+    const auto fg = _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(foreground)), zero);
+    const auto bg = _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(background)), zero);
+    const auto full = _mm_set1_epi16(255);
+    const auto bias = _mm_set1_epi16(128);
+    auto blend = [&](__m128i a) {
+        auto v = _mm_add_epi16(_mm_mullo_epi16(fg, a), _mm_mullo_epi16(bg, _mm_sub_epi16(full, a)));
+        v = _mm_add_epi16(v, bias);
+        return _mm_srli_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)), 8);
+    };
+    for (; i + 4 <= count; i += 4) {
+        uint32_t coverage = uint32_t{ glyph_row[tex_x[i]] } | uint32_t{ glyph_row[tex_x[i + 1]] } << 8 |
+            uint32_t{ glyph_row[tex_x[i + 2]] } << 16 | uint32_t{ glyph_row[tex_x[i + 3]] } << 24;
+        __m128i result;
+        if (coverage == 0) {
+            result = _mm_set1_epi32(static_cast<int>(background));
+        }
+        else if (coverage == UINT32_MAX) {
+            result = _mm_set1_epi32(static_cast<int>(foreground));
+        }
+        else {
+            // every coverage byte widened to 16 bits and repeated for the 4 channels of its pixel.
+            auto a = _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(coverage)), zero);
+            a = _mm_unpacklo_epi16(a, a);
+            result = _mm_packus_epi16(blend(_mm_unpacklo_epi32(a, a)), blend(_mm_unpackhi_epi32(a, a)));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), result);
+    }
+#endif
+    auto fg_channels = std::bit_cast<std::array<uint8_t, 4>>(foreground);
+    auto bg_channels = std::bit_cast<std::array<uint8_t, 4>>(background);
+    for (; i < count; i++) {
+        uint32_t a = glyph_row[tex_x[i]];
+        std::array<uint8_t, 4> channels;
+        for (size_t c = 0; c < 4; c++) {
+            uint32_t v = fg_channels[c] * a + bg_channels[c] * (255 - a) + 128;
+            channels[c] = static_cast<uint8_t>((v + (v >> 8)) >> 8);
+        }
+        out[i] = std::bit_cast<uint32_t>(channels);
+    }
+}
+
+struct pixel_rect {
+    int32_t x;
+    int32_t y;
+    uint32_t width;
+    uint32_t height;
+};
+
+// Draws panes into a software_framebuffer on the CPU, for hosts without a usable Vulkan device.
+// Same init/notify_update/run interface as renderer_presenter and the glyph bitmaps of render_glyph_bitmaps,
+// written into fixed glyph tiles.
+// A frame only repaints the cell rows that differ from the cells painted last time,
+// the dirty rows are split between threads when there are enough of them.
+class software_renderer {
+public:
+    // rows repainted by the calling thread before more threads are worth starting.
+    static constexpr size_t min_rows_per_thread = 8;
+    // bitmaps of the characters at the tile metrics, in the order of the characters.
+    using glyph_source = std::function<std::vector<glyph_bitmap>(const std::vector<uint32_t>& characters, glyph_tile_metrics metrics)>;
+
+    software_renderer(uint32_t width, uint32_t height, std::optional<std::filesystem::path> shared_memory_path = {})
+        : m_framebuffer{ width, height, shared_memory_path }, m_palette{ generate_default_palette() },
+        m_clear_color{ pack_rgba8({ 1.0f, 1.0f, 1.0f, 1.0f }) }, m_repaint_all{ true } {
+        // the fonts are opened with the first glyph and kept for the later ones.
+        m_glyph_source = [this](const std::vector<uint32_t>& characters, glyph_tile_metrics metrics) {
+            if (!m_font_loader) {
+                m_font_loader.emplace();
+            }
+            return render_glyph_bitmaps(*m_font_loader, characters, metrics, 0, false, 0.0f);
+        };
+    }
+    void init(multidimention_vector<terminal_cell>& terminal_buffer) {
+        m_panes.clear();
+        add_pane(terminal_buffer, pixel_rect{ 0, 0, m_framebuffer.get_width(), m_framebuffer.get_height() });
+        notify_update();
+    }
+    // the pane is drawn after the next notify_update.
+    size_t add_pane(multidimention_vector<terminal_cell>& terminal_buffer, pixel_rect viewport) {
+        m_panes.emplace_back(pane{ &terminal_buffer, viewport, {}, {}, {}, {}, {}, {}, true });
+        return m_panes.size() - 1;
+    }
+    void set_pane_viewport(size_t pane_index, pixel_rect viewport) {
+        m_panes[pane_index].viewport = viewport;
+        m_repaint_all = true;
+    }
+    void set_palette(const color_palette& palette) {
+        m_palette = palette;
+        m_repaint_all = true;
+    }
+    // replaces the fonts, the glyphs already in the atlas are kept.
+    void set_glyph_source(glyph_source source) {
+        m_glyph_source = std::move(source);
+    }
+    void set_clear_color(cell_color color) {
+        m_clear_color = pack_rgba8(resolve_color(color, m_palette));
+        m_repaint_all = true;
+    }
+    // picks up new pane sizes and viewports, the next run repaints everything.
+    void notify_update() {
+        for (auto& pane : m_panes) {
+            layout_pane(pane);
+        }
+        m_repaint_all = true;
+    }
+    // a resized pane is laid out again by the next run.
+    void notify_pane_update(size_t pane_index) {
+        m_panes[pane_index].repaint = true;
+    }
+    run_result run() {
+        for (auto& pane : m_panes) {
+            if (pane.painted.get_width() != pane.terminal_buffer->get_width() ||
+                pane.painted.get_height() != pane.terminal_buffer->get_height()) {
+                layout_pane(pane);
+                m_repaint_all = true;
+            }
+        }
+        auto repaint_all = m_repaint_all;
+        std::vector<std::pair<size_t, size_t>> dirty_rows;
+        std::set<uint32_t> missing_glyphs;
+        for (size_t i = 0; i < m_panes.size(); i++) {
+            auto& pane = m_panes[i];
+            for (size_t y = 0; y < pane.terminal_buffer->get_height(); y++) {
+                auto row = pane.terminal_buffer->get_row(y);
+                if (repaint_all || pane.repaint || !std::ranges::equal(row, pane.painted.get_row(y))) {
+                    dirty_rows.emplace_back(i, y);
+                    for (auto& cell : row) {
+                        if (get_glyph_index(cell) < 0) {
+                            missing_glyphs.emplace(cell.character);
+                        }
+                    }
+                }
+            }
+            pane.repaint = false;
+        }
+        m_repaint_all = false;
+        if (!missing_glyphs.empty()) {
+            add_glyphs(missing_glyphs);
+        }
+        if (!repaint_all && dirty_rows.empty()) {
+            return run_result::eContinue;
+        }
+        m_framebuffer.begin_frame();
+        if (repaint_all) {
+            std::ranges::fill(m_framebuffer.get_pixels(), m_clear_color);
+        }
+        auto thread_count = std::clamp<size_t>(std::thread::hardware_concurrency(), 1,
+            std::max<size_t>(dirty_rows.size() / min_rows_per_thread, 1));
+        if (thread_count == 1) {
+            for (auto [pane_index, y] : dirty_rows) {
+                paint_row(m_panes[pane_index], y);
+            }
+        }
+        else {
+            std::atomic<size_t> next_row{ 0 };
+            std::vector<std::jthread> threads;
+            for (size_t t = 0; t < thread_count; t++) {
+                threads.emplace_back([this, &dirty_rows, &next_row]() {
+                    for (auto i = next_row++; i < dirty_rows.size(); i = next_row++) {
+                        paint_row(m_panes[dirty_rows[i].first], dirty_rows[i].second);
+                    }
+                    });
+            }
+        }
+        m_framebuffer.end_frame();
+        return run_result::eContinue;
+    }
+    software_framebuffer& get_framebuffer() {
+        return m_framebuffer;
+    }
+    const software_framebuffer& get_framebuffer() const {
+        return m_framebuffer;
+    }
+private:
+    struct pane {
+        multidimention_vector<terminal_cell>* terminal_buffer;
+        pixel_rect viewport;
+        // cells as they were painted, a row is repainted when it differs.
+        multidimention_vector<terminal_cell> painted;
+        // framebuffer pixel bounds of every column and row, count + 1 entries each.
+        std::vector<uint32_t> column_starts;
+        std::vector<uint32_t> row_starts;
+        // glyph tile texel of every pixel of the viewport, relative to its cell.
+        std::vector<uint16_t> tex_x;
+        std::vector<uint16_t> tex_y;
+        // underline and strikethrough bits of every pixel row of the viewport.
+        std::vector<uint8_t> line_styles;
+        bool repaint;
+    };
+    // the viewport is clipped to the framebuffer, cells are stretched over it like the Vulkan renderers do.
+    void layout_pane(pane& pane) {
+        auto& buffer = *pane.terminal_buffer;
+        pane.painted = multidimention_vector<terminal_cell>{ buffer.get_width(), buffer.get_height() };
+        pane.repaint = true;
+        auto fit_axis = [](int32_t start, uint32_t size, uint32_t limit) {
+            auto begin = std::clamp<int64_t>(start, 0, limit);
+            auto end = std::clamp<int64_t>(int64_t{ start } + size, 0, limit);
+            return std::pair{ static_cast<uint32_t>(begin), static_cast<uint32_t>(end) };
+        };
+        auto [x_begin, x_end] = fit_axis(pane.viewport.x, pane.viewport.width, m_framebuffer.get_width());
+        auto [y_begin, y_end] = fit_axis(pane.viewport.y, pane.viewport.height, m_framebuffer.get_height());
+        auto split = [](uint32_t begin, uint32_t end, size_t count) {
+            std::vector<uint32_t> starts(count + 1);
+            for (size_t i = 0; i <= count; i++) {
+                starts[i] = begin + static_cast<uint32_t>(uint64_t{ end - begin } * i / std::max<size_t>(count, 1));
+            }
+            return starts;
+        };
+        pane.column_starts = split(x_begin, x_end, buffer.get_width());
+        pane.row_starts = split(y_begin, y_end, buffer.get_height());
+        // texels are sampled at pixel centers, like a nearest filter would.
+        auto sample = [](const std::vector<uint32_t>& starts, uint32_t texel_count, std::vector<uint16_t>& texels) {
+            texels.assign(starts.back() - starts.front(), 0);
+            for (size_t i = 0; i + 1 < starts.size(); i++) {
+                auto size = starts[i + 1] - starts[i];
+                for (uint32_t p = 0; p < size; p++) {
+                    texels[starts[i] - starts.front() + p] = static_cast<uint16_t>((2 * p + 1) * texel_count / (2 * size));
+                }
+            }
+        };
+        sample(pane.column_starts, m_metrics.font_width, pane.tex_x);
+        sample(pane.row_starts, m_metrics.line_height, pane.tex_y);
+        pane.line_styles.assign(pane.tex_y.size(), 0);
+        for (size_t y = 0; y + 1 < pane.row_starts.size(); y++) {
+            auto size = pane.row_starts[y + 1] - pane.row_starts[y];
+            for (uint32_t p = 0; p < size; p++) {
+                // same bands as fragment.glsl.
+                float cell_y = (p + 0.5f) / size;
+                uint8_t line_style = 0;
+                if (cell_y >= 0.52f && cell_y < 0.55f) {
+                    line_style |= eUnderline;
+                }
+                if (cell_y >= 0.36f && cell_y < 0.39f) {
+                    line_style |= eStrikethrough;
+                }
+                pane.line_styles[pane.row_starts[y] - pane.row_starts.front() + p] = line_style;
+            }
+        }
+    }
+    int32_t get_glyph_index(const terminal_cell& cell) const {
+        auto index = m_glyph_indices.find(cell.character);
+        return index != m_glyph_indices.end() ? index->second : -1;
+    }
+    size_t get_tile_size() const {
+        return size_t{ m_metrics.font_width } * m_metrics.line_height;
+    }
+    // only the new glyphs are rendered and appended as tiles, the tiles already there keep their index.
+    void add_glyphs(const std::set<uint32_t>& glyphs) {
+        auto characters = std::vector<uint32_t>{ glyphs.begin(), glyphs.end() };
+        auto bitmaps = m_glyph_source(characters, m_metrics);
+        auto first_tile = m_characters.size();
+        m_atlas.resize((first_tile + characters.size()) * get_tile_size(), 0);
+        for (size_t i = 0; i < characters.size(); i++) {
+            m_glyph_indices.emplace(characters[i], static_cast<int32_t>(first_tile + i));
+            m_characters.push_back(characters[i]);
+            write_glyph_tile(bitmaps[i], m_atlas.data() + (first_tile + i) * get_tile_size(), m_metrics.font_width, m_metrics);
+        }
+    }
+    // paints one cell row of a pane and records its cells as painted, rows never share pixels.
+    void paint_row(pane& pane, size_t y) {
+        struct cell_paint {
+            uint32_t foreground;
+            uint32_t background;
+            int32_t glyph_index;
+            uint32_t style;
+        };
+        auto row = pane.terminal_buffer->get_row(y);
+        std::vector<cell_paint> cells(row.size());
+        std::ranges::transform(row, cells.begin(), [this](auto& cell) {
+            auto foreground = cell.foreground;
+            auto background = cell.background;
+            if (cell.style & eInverse) {
+                std::swap(foreground, background);
+            }
+            return cell_paint{
+                pack_rgba8(resolve_color(foreground, m_palette)), pack_rgba8(resolve_color(background, m_palette)),
+                get_glyph_index(cell), cell.style };
+            });
+        auto x_origin = pane.column_starts.front();
+        for (auto py = pane.row_starts[y]; py < pane.row_starts[y + 1]; py++) {
+            auto out = m_framebuffer.get_row(py);
+            auto tex_row = m_atlas.data() + pane.tex_y[py - pane.row_starts.front()] * size_t{ m_metrics.font_width };
+            auto line_style = pane.line_styles[py - pane.row_starts.front()];
+            for (size_t x = 0; x < cells.size(); x++) {
+                auto& cell = cells[x];
+                auto begin = pane.column_starts[x];
+                auto count = pane.column_starts[x + 1] - begin;
+                if ((cell.style & line_style) != 0) {
+                    std::fill_n(out.data() + begin, count, cell.foreground);
+                }
+                else {
+                    blend_glyph_span(out.data() + begin, tex_row + static_cast<size_t>(cell.glyph_index) * get_tile_size(),
+                        pane.tex_x.data() + (begin - x_origin), count, cell.foreground, cell.background);
+                }
+            }
+        }
+        std::ranges::copy(row, pane.painted.get_row(y).begin());
+    }
+    software_framebuffer m_framebuffer;
+    std::vector<pane> m_panes;
+    glyph_tile_metrics m_metrics;
+    // code points of the tiles in atlas order.
+    std::vector<uint32_t> m_characters;
+    std::unordered_map<uint32_t, int32_t> m_glyph_indices;
+    // 8 bit coverage tiles of font_width x line_height, one below the other in glyph index order.
+    std::vector<unsigned char> m_atlas;
+    glyph_source m_glyph_source;
+    std::optional<font_loader> m_font_loader;
+    color_palette m_palette;
+    uint32_t m_clear_color;
+    bool m_repaint_all;
+};
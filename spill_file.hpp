@@ -0,0 +1,167 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef __unix__
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#endif
+
+// Append only scratch file mapped into memory, written like spirv_file reads: data lives in the
+// mapping and pages are only faulted in when they are touched. The file is created nameless in directory
+// with O_TMPFILE, or under a fresh mkstemp name that is unlinked right away, so it goes away with the
+// process and no existing file is ever touched. On Windows it is a new file that is deleted on close.
+// Other platforms have no spill file, see is_supported.
+class spill_file {
+public:
+    static constexpr size_t min_capacity = 1024 * 1024;
+#if defined(__unix__) || defined(_WIN32)
+    static constexpr bool is_supported = true;
+#else
+    static constexpr bool is_supported = false;
+#endif
+
+    spill_file([[maybe_unused]] std::filesystem::path directory)
+        : m_size{}, m_capacity{} {
+#ifdef __unix__
+        m_file_descriptor = -1;
+#ifdef O_TMPFILE
+        m_file_descriptor = open(directory.c_str(), O_TMPFILE | O_RDWR | O_EXCL, 0600);
+#endif
+        // file systems without O_TMPFILE support.
+        if (m_file_descriptor == -1) {
+            auto name = (directory / "spill_XXXXXX").string();
+            m_file_descriptor = mkstemp(name.data());
+            if (m_file_descriptor == -1) {
+                throw std::runtime_error{ "failed to create spill file" };
+            }
+            unlink(name.c_str());
+        }
+        mmaped_ptr = nullptr;
+#elif defined(_WIN32)
+        // CREATE_NEW fails instead of opening a file that happens to have the same name.
+        hFile = INVALID_HANDLE_VALUE;
+        std::random_device random{};
+        for (int attempt = 0; attempt < 16 && hFile == INVALID_HANDLE_VALUE; attempt++) {
+            auto path = directory / ("spill_" + std::to_string(random()) + std::to_string(random()));
+            hFile = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_NEW,
+                FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+            if (hFile == INVALID_HANDLE_VALUE && GetLastError() != ERROR_FILE_EXISTS) {
+                break;
+            }
+        }
+        if (hFile == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error{ "failed to create spill file" };
+        }
+        hMapping = NULL;
+        mmaped_ptr = nullptr;
+#else
+        throw std::runtime_error{ "spill files are not supported on this platform" };
+#endif
+    }
+    spill_file(const spill_file& file) = delete;
+    spill_file(spill_file&& file) = delete;
+    ~spill_file() {
+#ifdef __unix__
+        if (mmaped_ptr != nullptr) {
+            munmap(mmaped_ptr, m_capacity);
+        }
+        close(m_file_descriptor);
+#elif defined(_WIN32)
+        unmap();
+        CloseHandle(hFile);
+#endif
+    }
+    spill_file& operator=(const spill_file& file) = delete;
+    spill_file& operator=(spill_file&& file) = delete;
+
+    // returns the offset the data was written at.
+    size_t append(std::span<const std::byte> data) {
+        if (m_size + data.size() > m_capacity) {
+            reserve(std::max({ m_capacity * 2, m_size + data.size(), min_capacity }));
+        }
+        auto offset = m_size;
+        std::memcpy(get_pointer() + offset, data.data(), data.size());
+        m_size += data.size();
+        return offset;
+    }
+    // only valid until the next append.
+    std::span<const std::byte> read(size_t offset, size_t size) const {
+        return std::span<const std::byte>{ get_pointer() + offset, size };
+    }
+    size_t size() const {
+        return m_size;
+    }
+private:
+    void reserve(size_t capacity) {
+#ifdef __unix__
+        if (ftruncate(m_file_descriptor, capacity) == -1) {
+            throw std::runtime_error{ "failed to grow spill file" };
+        }
+        if (mmaped_ptr != nullptr) {
+            munmap(mmaped_ptr, m_capacity);
+        }
+        mmaped_ptr = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, m_file_descriptor, 0);
+        if (mmaped_ptr == MAP_FAILED) {
+            mmaped_ptr = nullptr;
+            throw std::runtime_error{ "failed to map spill file" };
+        }
+#elif defined(_WIN32)
+        // a mapping larger than the file grows the file.
+        unmap();
+        auto size = static_cast<uint64_t>(capacity);
+        hMapping = CreateFileMappingW(hFile, NULL, PAGE_READWRITE, static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), NULL);
+        if (hMapping == NULL) {
+            throw std::runtime_error{ "failed to grow spill file" };
+        }
+        mmaped_ptr = MapViewOfFile(hMapping, FILE_MAP_ALL_ACCESS, 0, 0, capacity);
+        if (mmaped_ptr == nullptr) {
+            throw std::runtime_error{ "failed to map spill file" };
+        }
+#endif
+        m_capacity = capacity;
+    }
+#ifdef _WIN32
+    void unmap() {
+        if (mmaped_ptr != nullptr) {
+            UnmapViewOfFile(mmaped_ptr);
+            mmaped_ptr = nullptr;
+        }
+        if (hMapping != NULL) {
+            CloseHandle(hMapping);
+            hMapping = NULL;
+        }
+    }
+#endif
+    std::byte* get_pointer() const {
+#if defined(__unix__) || defined(_WIN32)
+        return static_cast<std::byte*>(mmaped_ptr);
+#else
+        return nullptr;
+#endif
+    }
+#ifdef __unix__
+    int m_file_descriptor;
+    void* mmaped_ptr;
+#elif defined(_WIN32)
+    HANDLE hFile;
+    HANDLE hMapping;
+    void* mmaped_ptr;
+#endif
+    size_t m_size;
+    size_t m_capacity;
+};
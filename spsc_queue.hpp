@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <span>
+
+// Lock free ring for exactly one producer thread and one consumer thread.
+// Neither side ever waits for the other, a full ring makes try_push return less than requested.
+template<class T, size_t Capacity>
+class spsc_queue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+public:
+    spsc_queue() : m_data{ std::make_unique<T[]>(Capacity) }, m_head{}, m_tail{}, m_cached_head{}, m_cached_tail{} {}
+    spsc_queue(const spsc_queue&) = delete;
+    spsc_queue& operator=(const spsc_queue&) = delete;
+
+    // producer side, the whole batch becomes visible to the consumer with one store.
+    size_t try_push(std::span<const T> values) {
+        auto tail = m_tail.load(std::memory_order_relaxed);
+        if (Capacity - (tail - m_cached_head) < values.size()) {
+            m_cached_head = m_head.load(std::memory_order_acquire);
+        }
+        auto count = std::min(values.size(), Capacity - (tail - m_cached_head));
+        for (size_t i = 0; i < count; i++) {
+            m_data[(tail + i) & (Capacity - 1)] = values[i];
+        }
+        m_tail.store(tail + count, std::memory_order_release);
+        return count;
+    }
+    bool try_push(const T& value) {
+        return try_push(std::span<const T>{ &value, 1 }) == 1;
+    }
+
+    // consumer side, calls f for everything published so far and releases the slots at once.
+    size_t pop_all(auto&& f) {
+        auto head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cached_tail) {
+            m_cached_tail = m_tail.load(std::memory_order_acquire);
+        }
+        auto tail = m_cached_tail;
+        for (auto i = head; i != tail; i++) {
+            f(m_data[i & (Capacity - 1)]);
+        }
+        m_head.store(tail, std::memory_order_release);
+        return tail - head;
+    }
+    bool empty() const {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+    static constexpr size_t capacity() {
+        return Capacity;
+    }
+private:
+    std::unique_ptr<T[]> m_data;
+    // head is written by the consumer and tail by the producer, each on its own cache line.
+    alignas(64) std::atomic<size_t> m_head;
+    alignas(64) std::atomic<size_t> m_tail;
+    // producer's last seen head and consumer's last seen tail, to avoid touching the other side's line.
+    alignas(64) size_t m_cached_head;
+    alignas(64) size_t m_cached_tail;
+};
@@ -1,7 +1,38 @@
 #version 460
 
 #extension GL_EXT_mesh_shader : enable
+#extension GL_GOOGLE_include_directive : require
+
+#include "pane_parameters.glsl"
+#include "cell_occupancy.glsl"
+
+// one invocation per row, only the meshlets of a row that have a visible cell become mesh workgroups.
+// workgroup y covers words [y*max_occupancy_words_per_row, (y+1)*max_occupancy_words_per_row) of its rows,
+// so the payload never holds more than max_occupancy_words_per_row words of a row.
+layout(local_size_x=rows_per_task_workgroup) in;
+
+shared uint meshlet_count;
 
 void main() {
-    EmitMeshTasksEXT(16, 1, 1);
-}
\ No newline at end of file
+    if (gl_LocalInvocationIndex == 0) {
+        meshlet_count = 0;
+    }
+    barrier();
+    uint row = gl_WorkGroupID.x * rows_per_task_workgroup + gl_LocalInvocationID.x;
+    if (row < pane.height) {
+        uint first_word = gl_WorkGroupID.y * max_occupancy_words_per_row;
+        uint end_word = min(first_word + max_occupancy_words_per_row, occupancy_words_per_row(pane.width));
+        for (uint meshlet = first_word / meshlet_words; meshlet * meshlet_words < end_word; meshlet++) {
+            uint words = 0;
+            for (uint i = 0; i < meshlet_words; i++) {
+                words |= occupancy_word(row, meshlet * meshlet_words + i, pane.width);
+            }
+            if (words != 0u) {
+                uint index = atomicAdd(meshlet_count, 1);
+                payload.meshlets[index] = (row << 16) | meshlet;
+            }
+        }
+    }
+    barrier();
+    EmitMeshTasksEXT(meshlet_count, 1, 1);
+}
@@ -3,6 +3,11 @@
 
 inline std::string vertex_shader_path = "${vertex_shader_path}";
 inline std::string fragment_shader_path = "${fragment_shader_path}";
-inline std::string mesh_shader_path = "${mesh_shader_path}";
+inline std::string fragment_sdf_shader_path = "${fragment_sdf_shader_path}";
+inline std::string mesh_meshlet32_shader_path = "${mesh_meshlet32_shader_path}";
+inline std::string mesh_meshlet64_shader_path = "${mesh_meshlet64_shader_path}";
 inline std::string geometry_shader_path = "${geometry_shader_path}";
-inline std::string task_shader_path = "${task_shader_path}";
\ No newline at end of file
+inline std::string task_meshlet32_shader_path = "${task_meshlet32_shader_path}";
+inline std::string task_meshlet64_shader_path = "${task_meshlet64_shader_path}";
+inline std::string overlay_vertex_shader_path = "${overlay_vertex_shader_path}";
+inline std::string overlay_fragment_shader_path = "${overlay_fragment_shader_path}";
\ No newline at end of file
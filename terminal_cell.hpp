@@ -0,0 +1,124 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <utility>
+
+// style bits of terminal_cell, eForegroundPalette and eBackgroundPalette are owned by packed_cell.
+enum cell_style_bits : uint32_t {
+    eForegroundPalette = 1 << 0,
+    eBackgroundPalette = 1 << 1,
+    eUnderline = 1 << 2,
+    eStrikethrough = 1 << 3,
+    eInverse = 1 << 4,
+};
+
+class cell_color {
+public:
+    constexpr cell_color() : m_value{}, m_is_palette{} {}
+    static constexpr cell_color rgb(uint8_t r, uint8_t g, uint8_t b) {
+        return cell_color{ static_cast<uint32_t>(r) << 16 | static_cast<uint32_t>(g) << 8 | b, false };
+    }
+    static constexpr cell_color palette(uint8_t index) {
+        return cell_color{ index, true };
+    }
+    // 24 bit rgb, or palette index in the low 8 bits.
+    constexpr uint32_t get_value() const {
+        return m_value;
+    }
+    constexpr bool is_palette() const {
+        return m_is_palette;
+    }
+    constexpr bool operator==(const cell_color&) const = default;
+private:
+    constexpr cell_color(uint32_t value, bool is_palette) : m_value{ value }, m_is_palette{ is_palette } {}
+    uint32_t m_value;
+    bool m_is_palette;
+};
+
+struct terminal_cell {
+    uint32_t character{};
+    cell_color foreground{ cell_color::rgb(0x00, 0x00, 0x00) };
+    cell_color background{ cell_color::rgb(0xff, 0xff, 0xff) };
+    uint32_t style{};
+    constexpr bool operator==(const terminal_cell&) const = default;
+};
+
+// GPU side cell, decoded by packed_cell.glsl. Three uints, so the buffer is read as a uint array.
+//   glyph:  [0..31] glyph index
+//   foreground: [0..23] foreground, [24..27] style
+//   background: [0..23] background
+class packed_cell {
+public:
+    constexpr packed_cell() : m_glyph{}, m_foreground{}, m_background{} {}
+    constexpr packed_cell(uint32_t glyph_index, uint32_t style, uint32_t foreground, uint32_t background)
+        : m_glyph{ glyph_index },
+        m_foreground{ (foreground & 0xffffff) | (style & 0xf) << 24 },
+        m_background{ background & 0xffffff } {}
+    constexpr uint32_t get_glyph_index() const {
+        return m_glyph;
+    }
+    constexpr uint32_t get_style() const {
+        return m_foreground >> 24 & 0xf;
+    }
+    constexpr uint32_t get_foreground() const {
+        return m_foreground & 0xffffff;
+    }
+    constexpr uint32_t get_background() const {
+        return m_background;
+    }
+    constexpr bool operator==(const packed_cell&) const = default;
+private:
+    uint32_t m_glyph;
+    uint32_t m_foreground;
+    uint32_t m_background;
+};
+static_assert(sizeof(packed_cell) == 12);
+
+inline constexpr packed_cell pack_cell(const terminal_cell& cell, uint32_t glyph_index) {
+    auto foreground = cell.foreground;
+    auto background = cell.background;
+    if (cell.style & eInverse) {
+        std::swap(foreground, background);
+    }
+    uint32_t style = (cell.style & (eUnderline | eStrikethrough)) |
+        (foreground.is_palette() ? static_cast<uint32_t>(eForegroundPalette) : 0) |
+        (background.is_palette() ? static_cast<uint32_t>(eBackgroundPalette) : 0);
+    return packed_cell{ glyph_index, style, foreground.get_value(), background.get_value() };
+}
+
+using color_palette = std::array<std::array<float, 4>, 256>;
+
+// xterm 256 colors: 16 system colors, 6x6x6 color cube, 24 grays.
+inline color_palette generate_default_palette() {
+    constexpr std::array<uint32_t, 16> system_colors{
+        0x000000, 0xcd0000, 0x00cd00, 0xcdcd00, 0x0000ee, 0xcd00cd, 0x00cdcd, 0xe5e5e5,
+        0x7f7f7f, 0xff0000, 0x00ff00, 0xffff00, 0x5c5cff, 0xff00ff, 0x00ffff, 0xffffff,
+    };
+    auto to_color = [](uint32_t rgb) {
+        return std::array<float, 4>{
+            (rgb >> 16 & 0xff) / 255.0f, (rgb >> 8 & 0xff) / 255.0f, (rgb & 0xff) / 255.0f, 1.0f };
+    };
+    color_palette palette{};
+    for (uint32_t i = 0; i < 16; i++) {
+        palette[i] = to_color(system_colors[i]);
+    }
+    for (uint32_t i = 0; i < 216; i++) {
+        auto level = [](uint32_t v) { return v == 0 ? 0u : 55 + v * 40; };
+        palette[16 + i] = to_color(level(i / 36) << 16 | level(i / 6 % 6) << 8 | level(i % 6));
+    }
+    for (uint32_t i = 0; i < 24; i++) {
+        uint32_t gray = 8 + i * 10;
+        palette[232 + i] = to_color(gray << 16 | gray << 8 | gray);
+    }
+    return palette;
+}
+
+inline std::array<float, 4> resolve_color(cell_color color, const color_palette& palette) {
+    if (color.is_palette()) {
+        return palette[color.get_value() & 0xff];
+    }
+    auto rgb = color.get_value();
+    return std::array<float, 4>{
+        (rgb >> 16 & 0xff) / 255.0f, (rgb >> 8 & 0xff) / 255.0f, (rgb & 0xff) / 255.0f, 1.0f };
+}
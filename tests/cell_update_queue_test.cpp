@@ -0,0 +1,78 @@
+#include "cell_update_queue.hpp"
+#include "check.hpp"
+
+#include <vector>
+
+static std::vector<cell_update> pop_updates(cell_update_queue& queue) {
+    std::vector<cell_update> updates;
+    queue.pop_all([&updates](const cell_update& update) { updates.push_back(update); });
+    return updates;
+}
+
+static terminal_cell make_cell(uint32_t character) {
+    return terminal_cell{ character, cell_color::rgb(0x10, 0x20, 0x30), cell_color::palette(4), eUnderline };
+}
+
+static void test_fill_merges_neighbours() {
+    cell_update_queue queue;
+    cell_update_writer writer{ queue };
+    writer.write_cell(0, 2, 1, make_cell('a'));
+    writer.write_cell(0, 3, 1, make_cell('a'));
+    writer.fill(0, 4, 1, 3, make_cell('a'));
+    // other pane, row, cell or a gap start a new update.
+    writer.write_cell(1, 7, 1, make_cell('a'));
+    writer.write_cell(1, 8, 2, make_cell('a'));
+    writer.write_cell(1, 9, 2, make_cell('b'));
+    writer.write_cell(1, 11, 2, make_cell('b'));
+    check(writer.flush());
+    auto updates = pop_updates(queue);
+    check(updates.size() == 5);
+    check(updates[0].pane == 0 && updates[0].x == 2 && updates[0].y == 1 && updates[0].count == 5);
+    check(updates[0].cell == make_cell('a'));
+    check(updates[1].pane == 1 && updates[1].x == 7 && updates[1].y == 1);
+    check(updates[2].x == 8 && updates[2].y == 2 && updates[2].count == 1);
+    check(updates[3].x == 9 && updates[3].count == 1 && updates[3].cell == make_cell('b'));
+    check(updates[4].x == 11);
+}
+
+static void test_write_row_runs() {
+    cell_update_queue queue;
+    cell_update_writer writer{ queue };
+    std::vector<terminal_cell> row(10);
+    row[3] = make_cell('x');
+    row[4] = make_cell('x');
+    writer.write_row(2, 5, row, 4);
+    check(writer.flush());
+    auto updates = pop_updates(queue);
+    check(updates.size() == 3);
+    check(updates[0].x == 4 && updates[0].count == 3 && updates[0].cell == terminal_cell{});
+    check(updates[1].x == 7 && updates[1].count == 2 && updates[1].cell == make_cell('x'));
+    check(updates[2].x == 9 && updates[2].count == 5 && updates[2].cell == terminal_cell{});
+    for (auto& update : updates) {
+        check(update.pane == 2 && update.y == 5);
+    }
+}
+
+static void test_flush_full_queue() {
+    cell_update_queue queue;
+    cell_update_writer writer{ queue };
+    auto update_count = cell_update_queue::capacity() + 10;
+    for (uint32_t y = 0; y < update_count; y++) {
+        writer.write_cell(0, 0, y, make_cell('a'));
+    }
+    check(!writer.flush());
+    check(pop_updates(queue).size() == cell_update_queue::capacity());
+    // nothing is published twice and a published update is not merged into any more.
+    writer.write_cell(0, 1, 0, make_cell('a'));
+    check(writer.flush());
+    auto updates = pop_updates(queue);
+    check(updates.size() == 11);
+    check(updates.front().y == cell_update_queue::capacity());
+    check(updates.back().x == 1 && updates.back().y == 0 && updates.back().count == 1);
+}
+
+int main() {
+    test_fill_merges_neighbours();
+    test_write_row_runs();
+    test_flush_full_queue();
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+#include <source_location>
+
+// the tests are plain executables, a failed check prints where it is and fails the test for ctest.
+inline void check(bool condition, std::source_location location = std::source_location::current()) {
+    if (!condition) {
+        std::cerr << location.file_name() << ":" << location.line() << ": check failed" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+}
@@ -0,0 +1,49 @@
+#include "font_loader.hpp"
+#include "check.hpp"
+
+#include <cstdint>
+#include <map>
+#include <random>
+
+static void test_find_and_insert() {
+    glyph_lookup_cache cache{};
+    check(cache.find('a') == nullptr);
+    cache.insert('a', { 0, 5 });
+    cache.insert(0x4e2d, { 2, 900 });
+    auto a = cache.find('a');
+    check(a != nullptr && a->face_index == 0 && a->glyph_index == 5);
+    check(cache.find(0x4e2d)->face_index == 2 && cache.find(0x4e2d)->glyph_index == 900);
+    check(cache.find('b') == nullptr);
+    // the largest codepoint value is a key like any other.
+    check(cache.find(UINT32_MAX) == nullptr);
+    cache.insert(UINT32_MAX, { 3, 7 });
+    check(cache.find(UINT32_MAX) != nullptr && cache.find(UINT32_MAX)->glyph_index == 7);
+    // inserting again replaces the location.
+    cache.insert('a', { 1, 6 });
+    check(cache.find('a')->face_index == 1 && cache.find('a')->glyph_index == 6);
+}
+
+// enough codepoints to grow the table several times, checked against a map.
+static void test_grow() {
+    glyph_lookup_cache cache{};
+    std::map<uint32_t, glyph_lookup_cache::glyph_location> expected;
+    std::mt19937 random{ 36 };
+    for (uint32_t i = 0; i < 5000; i++) {
+        auto codepoint = static_cast<uint32_t>(random() % 0x110000);
+        auto location = glyph_lookup_cache::glyph_location{ i % 4, i };
+        cache.insert(codepoint, location);
+        expected[codepoint] = location;
+    }
+    for (auto& [codepoint, location] : expected) {
+        auto found = cache.find(codepoint);
+        check(found != nullptr && found->face_index == location.face_index && found->glyph_index == location.glyph_index);
+    }
+    for (uint32_t codepoint = 0; codepoint < 0x110000; codepoint += 97) {
+        check((cache.find(codepoint) != nullptr) == expected.contains(codepoint));
+    }
+}
+
+int main() {
+    test_find_and_insert();
+    test_grow();
+}
@@ -0,0 +1,76 @@
+#include "glyph_tiles.hpp"
+#include "check.hpp"
+
+#include <vector>
+
+constexpr glyph_tile_metrics metrics{ 4, 3, 5 };
+constexpr unsigned char untouched = 7;
+
+// a width x height bitmap whose pixel (x, y) is 10 * (y + 1) + x + 1.
+static glyph_bitmap make_bitmap(uint32_t width, uint32_t height, int32_t left, int32_t top) {
+    auto bitmap = glyph_bitmap{ width, height, left, top, std::vector<unsigned char>(size_t{ width } * height) };
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            bitmap.pixels[y * width + x] = static_cast<unsigned char>(10 * (y + 1) + x + 1);
+        }
+    }
+    return bitmap;
+}
+
+// the tile is written into a bigger image, so writes past the tile show up around it.
+static std::vector<unsigned char> write_tile(const glyph_bitmap& bitmap) {
+    constexpr size_t pitch = 8;
+    std::vector<unsigned char> image(pitch * 7, untouched);
+    write_glyph_tile(bitmap, image.data() + pitch + 2, pitch, metrics);
+    std::vector<unsigned char> tile;
+    for (size_t y = 0; y < 7; y++) {
+        for (size_t x = 0; x < pitch; x++) {
+            bool inside = y >= 1 && y < 1 + metrics.line_height && x >= 2 && x < 2 + metrics.font_width;
+            if (!inside) {
+                check(image[y * pitch + x] == untouched);
+            }
+            else {
+                tile.push_back(image[y * pitch + x]);
+            }
+        }
+    }
+    return tile;
+}
+
+static unsigned char at(const std::vector<unsigned char>& tile, size_t x, size_t y) {
+    return tile[y * metrics.font_width + x];
+}
+
+static void test_inside() {
+    auto tile = write_tile(make_bitmap(2, 2, 1, 2));
+    check(at(tile, 1, 2) == 11 && at(tile, 2, 2) == 12 && at(tile, 1, 3) == 21 && at(tile, 2, 3) == 22);
+    // only glyph pixels are written.
+    check(at(tile, 0, 2) == untouched && at(tile, 3, 3) == untouched && at(tile, 1, 1) == untouched && at(tile, 1, 4) == untouched);
+}
+
+static void test_clipped() {
+    // reaches past the top left corner.
+    auto tile = write_tile(make_bitmap(3, 3, -1, -2));
+    check(at(tile, 0, 0) == 32 && at(tile, 1, 0) == 33 && at(tile, 2, 0) == untouched && at(tile, 0, 1) == untouched);
+    // and past the bottom right corner.
+    tile = write_tile(make_bitmap(3, 4, 2, 3));
+    check(at(tile, 2, 3) == 11 && at(tile, 3, 3) == 12 && at(tile, 2, 4) == 21 && at(tile, 3, 4) == 22);
+    check(at(tile, 1, 3) == untouched);
+    // larger than the tile on every side.
+    tile = write_tile(make_bitmap(8, 9, -2, -3));
+    check(at(tile, 0, 0) == 43 && at(tile, 3, 4) == 86);
+}
+
+static void test_outside() {
+    for (auto bitmap : { make_bitmap(2, 2, 4, 0), make_bitmap(2, 2, -2, 0), make_bitmap(2, 2, 0, 5), make_bitmap(2, 2, 0, -2),
+        make_bitmap(0, 0, 1, 1) }) {
+        auto tile = write_tile(bitmap);
+        check(std::ranges::all_of(tile, [](auto pixel) { return pixel == untouched; }));
+    }
+}
+
+int main() {
+    test_inside();
+    test_clipped();
+    test_outside();
+}
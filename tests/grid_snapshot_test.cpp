@@ -0,0 +1,111 @@
+#include "grid_snapshot.hpp"
+#include "check.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+static void test_copy_on_write() {
+    triple_buffered_grid<uint32_t> grid{ 4, 3 };
+    grid.write(1, 1, 7);
+    grid.publish();
+    auto& first = grid.read();
+    check(first.width == 4 && first.height == 3);
+    check((first[{ 1, 1 }]) == 7);
+    auto first_rows = first.rows;
+    auto first_generation = first.generation;
+
+    grid.write(2, 1, 8);
+    // the snapshot being read does not change until it is published and read again.
+    check((first[{ 2, 1 }]) == 0);
+    grid.publish();
+    auto& second = grid.read();
+    check(second.generation > first_generation);
+    check((second[{ 1, 1 }]) == 7 && (second[{ 2, 1 }]) == 8);
+    check(first_rows[1]->cells[2] == 0);
+    // only the written row is new, the others are shared.
+    check(second.rows[0] == first_rows[0] && second.rows[2] == first_rows[2]);
+    check(second.rows[1] != first_rows[1] && second.rows[1]->version != first_rows[1]->version);
+}
+
+static void test_read_latest() {
+    triple_buffered_grid<uint32_t> grid{ 2, 2 };
+    auto& initial = grid.read();
+    auto generation = initial.generation;
+    check(&grid.read() == &initial);
+    for (uint32_t i = 1; i <= 3; i++) {
+        grid.write(0, 0, i);
+        grid.publish();
+    }
+    auto& latest = grid.read();
+    check(latest.generation == generation + 3);
+    check((latest[{ 0, 0 }]) == 3);
+}
+
+static void test_fill_and_rotate() {
+    triple_buffered_grid<uint32_t> grid{ 3, 4 };
+    for (uint32_t y = 0; y < 4; y++) {
+        grid.fill_row(y, y);
+    }
+    grid.publish();
+    auto published = grid.read().rows;
+    grid.fill_row(0, 9);
+    check(published[0]->cells[0] == 0);
+    grid.rotate_rows(0, 1, 4);
+    grid.publish();
+    auto& snapshot = grid.read();
+    check((snapshot[{ 0, 0 }]) == 1 && (snapshot[{ 0, 1 }]) == 2 && (snapshot[{ 0, 2 }]) == 3 && (snapshot[{ 2, 3 }]) == 9);
+    // rotated rows keep their versions.
+    check(snapshot.rows[0] == published[1] && snapshot.rows[2] == published[3]);
+}
+
+static void test_resize() {
+    triple_buffered_grid<uint32_t> grid{ 2, 2 };
+    grid.write(1, 1, 5);
+    grid.resize(3, 3);
+    grid.publish();
+    auto& snapshot = grid.read();
+    check(snapshot.width == 3 && snapshot.height == 3 && snapshot.rows.size() == 3);
+    check((snapshot[{ 1, 1 }]) == 5 && (snapshot[{ 2, 1 }]) == 0 && snapshot.rows[2]->cells.size() == 3);
+}
+
+// every publish writes one value to all cells, a reader must never see two values in one snapshot.
+static void test_threads() {
+    constexpr uint32_t publish_count = 20000;
+    triple_buffered_grid<uint32_t> grid{ 16, 8 };
+    std::atomic<bool> done{};
+    std::jthread writer{ [&grid, &done]() {
+        for (uint32_t i = 1; i <= publish_count; i++) {
+            for (size_t y = 0; y < grid.get_height(); y++) {
+                for (auto& cell : grid.get_row(y)) {
+                    cell = i;
+                }
+            }
+            grid.publish();
+        }
+        done = true;
+    } };
+    uint64_t last_generation = 0;
+    uint32_t last_value = 0;
+    while (!done || last_value < publish_count) {
+        auto& snapshot = grid.read();
+        check(snapshot.generation >= last_generation);
+        last_generation = snapshot.generation;
+        auto value = snapshot[{ 0, 0 }];
+        check(value >= last_value);
+        last_value = value;
+        for (auto& row : snapshot.rows) {
+            for (auto cell : row->cells) {
+                check(cell == value);
+            }
+        }
+    }
+}
+
+int main() {
+    test_copy_on_write();
+    test_read_latest();
+    test_fill_and_rotate();
+    test_resize();
+    test_threads();
+}
@@ -0,0 +1,93 @@
+#include "multidimention_array.hpp"
+#include "check.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <ranges>
+#include <vector>
+
+static_assert(std::random_access_iterator<strided_iterator<int>>);
+static_assert(std::random_access_iterator<strided_iterator<const int>>);
+static_assert(std::ranges::random_access_range<multidimention_view<int>>);
+
+// a 6x4 grid with 2 elements of padding after each row, cell (x, y) holds y * 10 + x.
+static multidimention_vector<int> make_grid() {
+    multidimention_vector<int> grid{ 6, 4, 8 };
+    for (size_t y = 0; y < grid.get_height(); y++) {
+        for (size_t x = 0; x < grid.get_width(); x++) {
+            grid[{ x, y }] = static_cast<int>(y * 10 + x);
+        }
+    }
+    return grid;
+}
+
+static void test_rows() {
+    auto grid = make_grid();
+    check(grid.size() == 24 && !grid.is_contiguous());
+    // iteration skips the padding between rows.
+    std::vector<int> cells{ grid.begin(), grid.end() };
+    check(cells.size() == grid.size());
+    for (size_t i = 0; i < cells.size(); i++) {
+        check(cells[i] == static_cast<int>(i / 6 * 10 + i % 6));
+    }
+    check(std::ranges::equal(grid.get_row(2), std::vector{ 20, 21, 22, 23, 24, 25 }));
+    // backwards over the row ends as well.
+    std::vector<int> reversed{ std::make_reverse_iterator(grid.end()), std::make_reverse_iterator(grid.begin()) };
+    check(std::ranges::equal(reversed, std::views::reverse(cells)));
+}
+
+static void test_columns() {
+    auto grid = make_grid();
+    for (size_t x = 0; x < grid.get_width(); x++) {
+        auto column = grid.get_subview(x, 0, 1, grid.get_height());
+        check(column.get_stride() == grid.get_stride() && column.size() == grid.get_height());
+        std::vector<int> cells{ column.begin(), column.end() };
+        check(std::ranges::equal(cells, std::vector{ 0, 10, 20, 30 } | std::views::transform([x](int v) { return v + static_cast<int>(x); })));
+    }
+}
+
+static void test_random_access() {
+    auto grid = make_grid();
+    auto view = grid.get_subview(1, 1, 3, 2);
+    auto begin = view.begin();
+    check(view.end() - begin == 6);
+    check(begin[0] == 11 && begin[2] == 13 && begin[3] == 21 && begin[5] == 23);
+    check(*(begin + 4) == 22 && *(view.end() - 1) == 23 && *(4 + begin) == 22);
+    auto it = begin + 5;
+    it -= 2;
+    check(*it == 21 && it > begin && it - begin == 3);
+    check(std::ranges::is_sorted(view));
+    // sorting a sub view only moves its own cells.
+    std::ranges::sort(view, std::greater<>{});
+    check(std::ranges::equal(std::vector<int>{ view.begin(), view.end() }, std::vector{ 23, 22, 21, 13, 12, 11 }));
+    check((grid[{ 0, 1 }]) == 10 && (grid[{ 4, 1 }]) == 14 && (grid[{ 1, 0 }]) == 1 && (grid[{ 1, 3 }]) == 31);
+}
+
+static void test_view_bounds() {
+    auto grid = make_grid();
+    // sub views reaching the right and bottom edges.
+    auto corner = grid.get_subview(4, 2, 2, 2);
+    check(corner.get_width() == 2 && corner.get_height() == 2);
+    check((corner[{ 0, 0 }]) == 24 && (corner[{ 1, 1 }]) == 35);
+    check(std::ranges::equal(corner.get_row(1), std::vector{ 34, 35 }));
+    auto nested = corner.get_subview(1, 0, 1, 2);
+    check((nested[{ 0, 1 }]) == 35 && nested.data() == &grid[{ 5, 2 }]);
+    // empty views have no cells to visit.
+    for (auto empty : { grid.get_subview(6, 0, 0, 4), grid.get_subview(0, 4, 6, 0), multidimention_view<int>{} }) {
+        check(empty.size() == 0 && empty.begin() == empty.end() && std::ranges::distance(empty) == 0);
+    }
+    // a full width view of a padded grid is contiguous only for a single row.
+    check(grid.get_subview(0, 1, 6, 1).is_contiguous() && !grid.get_subview(0, 1, 6, 2).is_contiguous());
+    multidimention_vector<int> dense{ 3, 2 };
+    std::iota(dense.begin(), dense.end(), 0);
+    check(dense.is_contiguous() && std::ranges::equal(dense.get_span(), std::vector{ 0, 1, 2, 3, 4, 5 }));
+    check(dense.get_linear_index({ 2, 1 }) == 5 && grid.get_linear_index({ 2, 1 }) == 8);
+}
+
+int main() {
+    test_rows();
+    test_columns();
+    test_random_access();
+    test_view_bounds();
+}
@@ -0,0 +1,119 @@
+#include "scrollback_store.hpp"
+#include "check.hpp"
+
+#include <string>
+#include <vector>
+
+constexpr size_t line_width = 80;
+
+// every third line is the same, the others differ in their text and colors.
+static std::vector<terminal_cell> make_line(size_t line) {
+    std::vector<terminal_cell> cells(line_width);
+    auto text = line % 3 == 0 ? std::string{ "repeated" } : "line " + std::to_string(line);
+    for (size_t x = 0; x < text.size(); x++) {
+        cells[x].character = static_cast<uint8_t>(text[x]);
+        cells[x].foreground = cell_color::palette(static_cast<uint8_t>(line % 3 == 0 ? 1 : line));
+    }
+    return cells;
+}
+
+static std::vector<terminal_cell> copy_line(const scrollback_store& store, size_t line, size_t width = line_width,
+    const terminal_cell& fill = terminal_cell{}) {
+    std::vector<terminal_cell> cells(width);
+    store.copy_line(line, cells, fill);
+    return cells;
+}
+
+static void test_round_trip() {
+    scrollback_store store{};
+    constexpr size_t line_count = scrollback_store::page_lines * 4 + 10;
+    for (size_t line = 0; line < line_count; line++) {
+        store.push_line(make_line(line));
+    }
+    check(store.get_line_count() == line_count);
+    check(store.get_dropped_line_count() == 0);
+    // the compressed pages and the hot page.
+    for (size_t line = 0; line < line_count; line++) {
+        check(copy_line(store, line) == make_line(line));
+    }
+    check(store.get_resident_bytes() < scrollback_store::page_lines * 4 * line_width * sizeof(terminal_cell) / 4);
+}
+
+static void test_other_widths() {
+    scrollback_store store{};
+    for (size_t line = 0; line < scrollback_store::page_lines + 1; line++) {
+        store.push_line(make_line(line));
+    }
+    auto fill = terminal_cell{ '.' };
+    for (size_t line : { size_t{ 1 }, size_t{ 3 }, scrollback_store::page_lines }) {
+        auto expected = make_line(line);
+        auto narrow = copy_line(store, line, 5, fill);
+        check(std::ranges::equal(narrow, std::span{ expected }.first(5)));
+        auto wide = copy_line(store, line, line_width + 3, fill);
+        check(std::ranges::equal(std::span{ wide }.first(line_width), expected));
+        check(wide[line_width] == fill && wide.back() == fill);
+    }
+}
+
+static void test_map_window() {
+    scrollback_store store{};
+    for (size_t line = 0; line < scrollback_store::page_lines + 2; line++) {
+        store.push_line(make_line(line));
+    }
+    auto fill = terminal_cell{ '.' };
+    multidimention_vector<terminal_cell> screen{ line_width + 2, 6 };
+    // a window at the end, its last rows are past the stored lines.
+    auto first_line = scrollback_store::page_lines - 1;
+    store.map_window(first_line, screen.get_subview(1, 1, line_width, 4), fill);
+    for (size_t y = 0; y < 4; y++) {
+        auto row = screen.get_row(1 + y).subspan(1, line_width);
+        if (first_line + y < store.get_line_count()) {
+            check(std::ranges::equal(row, make_line(first_line + y)));
+        }
+        else {
+            check(std::ranges::all_of(row, [&fill](auto& cell) { return cell == fill; }));
+        }
+    }
+    // the cells around the view are not touched.
+    check(screen.get_row(0)[0] == terminal_cell{} && screen.get_row(1)[0] == terminal_cell{});
+    check(screen.get_row(1)[line_width + 1] == terminal_cell{} && screen.get_row(5)[1] == terminal_cell{});
+}
+
+// 16 bytes a cell, the padding of terminal_cell is not stored.
+static void test_page_size() {
+    std::vector<terminal_cell> row(10, terminal_cell{ ' ', cell_color::palette(7), cell_color::rgb(1, 2, 3), eUnderline });
+    row[0].character = 'a';
+    row[2].foreground = cell_color::rgb(0xff, 0xfe, 0xfd);
+    auto page = scrollback_page::compress({ row, row });
+    // width and literal count, three literal cells and the tail cell, then a reference.
+    check(page.get_data_size() == 2 * sizeof(uint32_t) + 4 * 16 + sizeof(uint32_t));
+    std::vector<terminal_cell> out(10);
+    page.decompress_row(1, out, terminal_cell{}, nullptr);
+    check(out == row);
+}
+
+static void test_memory_cap() {
+    scrollback_store store{};
+    constexpr size_t line_count = scrollback_store::page_lines * 8;
+    for (size_t line = 0; line < line_count; line++) {
+        store.push_line(make_line(line));
+    }
+    auto page_bytes = store.get_resident_bytes() / 8;
+    store.set_memory_cap(page_bytes * 3);
+    check(store.get_resident_bytes() <= page_bytes * 3);
+    check(store.get_dropped_line_count() >= scrollback_store::page_lines * 4);
+    check(store.get_dropped_line_count() % scrollback_store::page_lines == 0);
+    check(store.get_dropped_line_count() + store.get_line_count() == line_count);
+    // the oldest lines go first, line 0 is the oldest one kept.
+    for (size_t line = 0; line < store.get_line_count(); line++) {
+        check(copy_line(store, line) == make_line(store.get_dropped_line_count() + line));
+    }
+}
+
+int main() {
+    test_round_trip();
+    test_other_widths();
+    test_map_window();
+    test_page_size();
+    test_memory_cap();
+}
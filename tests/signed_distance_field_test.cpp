@@ -0,0 +1,90 @@
+#include "signed_distance_field.hpp"
+#include "check.hpp"
+
+#include <random>
+#include <vector>
+
+// compares with the distance to every feature pixel.
+static void test_distance_transform() {
+    std::mt19937 random{ 35 };
+    for (auto [width, height] : { std::pair{ 1, 1 }, std::pair{ 7, 3 }, std::pair{ 16, 16 }, std::pair{ 5, 23 } }) {
+        std::vector<bool> feature(width * height);
+        for (size_t i = 0; i < feature.size(); i++) {
+            feature[i] = random() % 9 == 0;
+        }
+        feature[random() % feature.size()] = true;
+        auto distances = squared_distance_transform(feature, width, height);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                float nearest = far_distance;
+                for (int i = 0; i < width * height; i++) {
+                    if (feature[i]) {
+                        float dx = static_cast<float>(x - i % width);
+                        float dy = static_cast<float>(y - i / width);
+                        nearest = std::min(nearest, dx * dx + dy * dy);
+                    }
+                }
+                check(distances[y * width + x] == nearest);
+            }
+        }
+    }
+}
+
+static std::vector<unsigned char> make_square_tile(size_t size, size_t left, size_t right) {
+    std::vector<unsigned char> tile(size * size);
+    for (size_t y = left; y < right; y++) {
+        for (size_t x = left; x < right; x++) {
+            tile[y * size + x] = 255;
+        }
+    }
+    return tile;
+}
+
+static void test_coverage_to_signed_distance_field() {
+    constexpr size_t size = 24;
+    constexpr float spread = 3;
+    auto tile = make_square_tile(size, 8, 16);
+    coverage_to_signed_distance_field(tile.data(), size, size, size, spread);
+    auto at = [&tile](size_t x, size_t y) { return tile[y * size + x]; };
+    // half a pixel from the outline on either side.
+    check(at(8, 12) > 128 && at(7, 12) < 128);
+    check(at(8, 12) - 128 == 127 - at(7, 12));
+    // further inside is larger, further outside smaller, past the spread it saturates.
+    check(at(10, 12) > at(9, 12) && at(9, 12) > at(8, 12));
+    check(at(5, 12) < at(6, 12) && at(6, 12) < at(7, 12));
+    check(at(0, 0) == 0 && at(2, 12) == 0);
+    check(at(12, 12) == 255);
+}
+
+static void test_tiles() {
+    constexpr size_t tile_size = 12;
+    constexpr size_t columns = 3;
+    constexpr size_t tile_count = 7;
+    constexpr size_t pitch = tile_size * columns + 5;
+    std::vector<unsigned char> atlas(pitch * tile_size * 3, 77);
+    std::vector<std::vector<unsigned char>> expected;
+    for (size_t i = 0; i < tile_count; i++) {
+        auto tile = make_square_tile(tile_size, i % 4, tile_size - 1 - i % 3);
+        for (size_t y = 0; y < tile_size; y++) {
+            std::ranges::copy(std::span{ tile }.subspan(y * tile_size, tile_size),
+                atlas.begin() + ((i / columns) * tile_size + y) * pitch + (i % columns) * tile_size);
+        }
+        coverage_to_signed_distance_field(tile.data(), tile_size, tile_size, tile_size, 3);
+        expected.push_back(tile);
+    }
+    tiles_to_signed_distance_field(atlas.data(), pitch, tile_size, tile_size, tile_count, columns, 3);
+    for (size_t i = 0; i < tile_count; i++) {
+        for (size_t y = 0; y < tile_size; y++) {
+            auto row = atlas.begin() + ((i / columns) * tile_size + y) * pitch + (i % columns) * tile_size;
+            check(std::ranges::equal(std::span{ row, tile_size }, std::span{ expected[i] }.subspan(y * tile_size, tile_size)));
+        }
+    }
+    // the padding right of the tiles and the unused tile slots are not touched.
+    check(atlas[tile_size * columns] == 77 && atlas[atlas.size() - 1] == 77);
+}
+
+int main() {
+    test_distance_transform();
+    test_coverage_to_signed_distance_field();
+    test_tiles();
+}
@@ -0,0 +1,76 @@
+#include "glyph_packer.hpp"
+#include "check.hpp"
+
+#include <random>
+#include <vector>
+
+struct placed_rect {
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+};
+
+static bool overlap(const placed_rect& a, const placed_rect& b) {
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+static void test_exact_fit() {
+    skyline_packer packer{ 32, 32 };
+    check(!packer.insert(33, 1) && !packer.insert(1, 33));
+    // bottom left order, rows of squares fill the area without a gap.
+    for (uint32_t i = 0; i < 16; i++) {
+        auto position = packer.insert(8, 8);
+        check(position && position->x == i % 4 * 8 && position->y == i / 4 * 8);
+    }
+    check(packer.get_used_height() == 32);
+    check(!packer.insert(1, 1));
+}
+
+static void test_lowest_place() {
+    skyline_packer packer{ 30, 30 };
+    check(packer.insert(10, 12)->x == 0);
+    check(packer.insert(10, 4)->x == 10);
+    check(packer.insert(10, 8)->x == 20);
+    // the lowest skyline segment wins, then the leftmost of two equally low places.
+    auto position = packer.insert(10, 2);
+    check(position->x == 10 && position->y == 4);
+    position = packer.insert(20, 2);
+    check(position->x == 10 && position->y == 8);
+    check(packer.get_used_height() == 12);
+}
+
+static void test_random() {
+    std::mt19937 random{ 46 };
+    constexpr uint32_t size = 256;
+    skyline_packer packer{ size, size };
+    std::vector<placed_rect> placed;
+    uint32_t failures = 0;
+    while (failures < 20) {
+        auto width = 1 + static_cast<uint32_t>(random() % 24);
+        auto height = 1 + static_cast<uint32_t>(random() % 24);
+        auto position = packer.insert(width, height);
+        if (!position) {
+            failures++;
+            continue;
+        }
+        auto rect = placed_rect{ position->x, position->y, width, height };
+        check(rect.x + rect.width <= size && rect.y + rect.height <= size);
+        check(rect.y + rect.height <= packer.get_used_height());
+        for (auto& other : placed) {
+            check(!overlap(rect, other));
+        }
+        placed.push_back(rect);
+    }
+    uint64_t area = 0;
+    for (auto& rect : placed) {
+        area += rect.width * rect.height;
+    }
+    check(area > size * size / 2);
+}
+
+int main() {
+    test_exact_fit();
+    test_lowest_place();
+    test_random();
+}
@@ -0,0 +1,151 @@
+#include "software_renderer.hpp"
+#include "check.hpp"
+
+#include <array>
+#include <random>
+#include <thread>
+#include <vector>
+
+constexpr uint32_t cell_pixels = 4;
+
+// fixed glyphs instead of fonts: '#' covers the whole tile, '|' its left half, everything else is blank.
+static std::vector<glyph_bitmap> fixed_glyphs(const std::vector<uint32_t>& characters, glyph_tile_metrics metrics) {
+    std::vector<glyph_bitmap> bitmaps;
+    for (auto character : characters) {
+        auto width = character == '#' ? metrics.font_width : character == '|' ? metrics.font_width / 2 : 0;
+        auto height = width > 0 ? metrics.line_height : 0;
+        bitmaps.push_back(glyph_bitmap{ width, height, 0, 0, std::vector<unsigned char>(size_t{ width } * height, 255) });
+    }
+    return bitmaps;
+}
+
+static uint32_t to_pixel(cell_color color) {
+    return pack_rgba8(resolve_color(color, generate_default_palette()));
+}
+
+static uint32_t get_pixel(software_renderer& renderer, uint32_t x, uint32_t y) {
+    return renderer.get_framebuffer().get_row(y)[x];
+}
+
+static void test_blend_glyph_span() {
+    std::mt19937 random{ 39 };
+    std::vector<unsigned char> glyph_row(64);
+    for (auto& coverage : glyph_row) {
+        auto choice = random() % 3;
+        coverage = static_cast<unsigned char>(choice == 0 ? 0 : choice == 1 ? 255 : random() % 256);
+    }
+    std::vector<uint16_t> tex_x(37);
+    for (auto& x : tex_x) {
+        x = static_cast<uint16_t>(random() % glyph_row.size());
+    }
+    uint32_t foreground = 0xff102030;
+    uint32_t background = 0x80f0e0d0;
+    std::vector<uint32_t> out(tex_x.size());
+    blend_glyph_span(out.data(), glyph_row.data(), tex_x.data(), out.size(), foreground, background);
+    // the SIMD part has to match the scalar formula, a rounded mix of the two colors.
+    for (size_t i = 0; i < out.size(); i++) {
+        uint32_t a = glyph_row[tex_x[i]];
+        auto fg = std::bit_cast<std::array<uint8_t, 4>>(foreground);
+        auto bg = std::bit_cast<std::array<uint8_t, 4>>(background);
+        auto pixel = std::bit_cast<std::array<uint8_t, 4>>(out[i]);
+        for (size_t c = 0; c < 4; c++) {
+            auto exact = (fg[c] * a + bg[c] * (255 - a)) / 255.0;
+            check(std::abs(pixel[c] - exact) <= 0.5);
+        }
+    }
+}
+
+static void test_paint() {
+    multidimention_vector<terminal_cell> grid{ 3, 2 };
+    software_renderer renderer{ 3 * cell_pixels, 2 * cell_pixels };
+    std::vector<std::vector<uint32_t>> requested;
+    renderer.set_glyph_source([&requested](const std::vector<uint32_t>& characters, glyph_tile_metrics metrics) {
+        requested.push_back(characters);
+        return fixed_glyphs(characters, metrics);
+    });
+    auto background = terminal_cell{}.background;
+    auto foreground = cell_color::palette(1);
+    grid[{ 0, 0 }] = terminal_cell{ '#', foreground, background, 0 };
+    grid[{ 1, 0 }] = terminal_cell{ '|', foreground, background, 0 };
+    grid[{ 2, 1 }] = terminal_cell{ ' ', foreground, cell_color::rgb(0, 0, 0xff), eInverse };
+    renderer.init(grid);
+    renderer.run();
+    auto& framebuffer = renderer.get_framebuffer();
+    check(framebuffer.get_frame() == 2);
+    check(get_pixel(renderer, 0, 0) == to_pixel(foreground) && get_pixel(renderer, 3, 3) == to_pixel(foreground));
+    check(get_pixel(renderer, 4, 2) == to_pixel(foreground) && get_pixel(renderer, 7, 2) == to_pixel(background));
+    check(get_pixel(renderer, 0, 4) == to_pixel(background));
+    // inverse swaps the colors of the blank cell.
+    check(get_pixel(renderer, 9, 6) == to_pixel(foreground));
+    check(requested.size() == 1 && requested[0] == std::vector<uint32_t>{ 0, ' ', '#', '|' });
+
+    // nothing changed, nothing is painted.
+    renderer.run();
+    check(framebuffer.get_frame() == 2);
+    // a changed row is repainted, only the new glyph is rendered.
+    grid[{ 0, 1 }] = terminal_cell{ '#', cell_color::rgb(0, 0xff, 0), background, 0 };
+    grid[{ 1, 1 }] = terminal_cell{ 'a', foreground, background, eUnderline };
+    renderer.run();
+    check(framebuffer.get_frame() == 4);
+    check(requested.size() == 2 && requested[1] == std::vector<uint32_t>{ 'a' });
+    check(get_pixel(renderer, 1, 5) == to_pixel(cell_color::rgb(0, 0xff, 0)) && get_pixel(renderer, 0, 0) == to_pixel(foreground));
+    // the underline band of fragment.glsl, at 0.52 to 0.55 of the cell height.
+    software_renderer tall{ 3 * cell_pixels, 2 * 100 };
+    tall.set_glyph_source(fixed_glyphs);
+    tall.init(grid);
+    tall.run();
+    check(get_pixel(tall, 5, 100 + 53) == to_pixel(foreground) && get_pixel(tall, 5, 100 + 50) == to_pixel(background));
+}
+
+static void test_viewport() {
+    multidimention_vector<terminal_cell> grid{ 1, 1 };
+    grid[{ 0, 0 }] = terminal_cell{ '#', cell_color::palette(2), terminal_cell{}.background, 0 };
+    software_renderer renderer{ 8, 8 };
+    renderer.set_glyph_source(fixed_glyphs);
+    renderer.set_clear_color(cell_color::palette(4));
+    renderer.init(grid);
+    // partly outside of the framebuffer, the rest is the clear color.
+    renderer.set_pane_viewport(0, pixel_rect{ -4, 4, 8, 8 });
+    renderer.notify_update();
+    renderer.run();
+    check(get_pixel(renderer, 0, 4) == to_pixel(cell_color::palette(2)) && get_pixel(renderer, 3, 7) == to_pixel(cell_color::palette(2)));
+    check(get_pixel(renderer, 4, 4) == to_pixel(cell_color::palette(4)) && get_pixel(renderer, 0, 3) == to_pixel(cell_color::palette(4)));
+}
+
+// a reader copying while frames are painted only keeps copies of one whole frame.
+static void test_copy_frame() {
+    multidimention_vector<terminal_cell> grid{ 16, 16 };
+    software_renderer renderer{ 64, 64 };
+    renderer.set_glyph_source(fixed_glyphs);
+    renderer.init(grid);
+    renderer.run();
+    std::atomic<bool> done{};
+    std::jthread painter{ [&renderer, &grid, &done]() {
+        for (uint32_t i = 0; i < 300; i++) {
+            for (auto& cell : grid) {
+                cell.background = cell_color::rgb(static_cast<uint8_t>(i), 0, 0);
+            }
+            renderer.run();
+        }
+        done = true;
+    } };
+    auto& framebuffer = renderer.get_framebuffer();
+    std::vector<uint32_t> pixels(framebuffer.get_pixels().size());
+    size_t copies = 0;
+    while (!done) {
+        uint32_t frame;
+        if (framebuffer.copy_frame(pixels, frame)) {
+            check(frame % 2 == 0);
+            check(std::ranges::all_of(pixels, [&pixels](auto pixel) { return pixel == pixels.front(); }));
+            copies++;
+        }
+    }
+    check(copies > 0);
+}
+
+int main() {
+    test_blend_glyph_span();
+    test_paint();
+    test_viewport();
+    test_copy_frame();
+}
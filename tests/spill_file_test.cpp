@@ -0,0 +1,74 @@
+#include "spill_file.hpp"
+#include "scrollback_store.hpp"
+#include "check.hpp"
+
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+// a fresh directory, so the test can see that no file is left behind.
+static std::filesystem::path create_test_directory() {
+    auto directory = std::filesystem::temp_directory_path() / ("spill_file_test_" + std::to_string(std::random_device{}()));
+    check(std::filesystem::create_directory(directory));
+    return directory;
+}
+
+static void test_append_and_read(const std::filesystem::path& directory) {
+    spill_file file{ directory };
+    check(std::filesystem::is_empty(directory));
+    std::vector<std::byte> first(100, std::byte{ 1 });
+    // larger than the first mapping, so the file is grown and mapped again.
+    std::vector<std::byte> second(spill_file::min_capacity + 5, std::byte{ 2 });
+    check(file.append(first) == 0);
+    check(file.append(second) == first.size());
+    check(file.size() == first.size() + second.size());
+    check(std::ranges::equal(file.read(0, first.size()), first));
+    check(std::ranges::equal(file.read(first.size(), second.size()), second));
+}
+
+static void test_missing_directory(const std::filesystem::path& directory) {
+    bool thrown = false;
+    try {
+        spill_file file{ directory / "missing" };
+    }
+    catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    check(thrown);
+}
+
+static void test_scrollback_spill(const std::filesystem::path& directory) {
+    constexpr size_t line_count = scrollback_store::page_lines * 6;
+    auto make_line = [](size_t line) {
+        std::vector<terminal_cell> cells(40);
+        for (size_t x = 0; x < cells.size(); x++) {
+            cells[x].character = static_cast<uint32_t>(line * 7 + x);
+        }
+        return cells;
+    };
+    scrollback_store store{ scrollback_store::default_memory_cap, directory };
+    for (size_t line = 0; line < line_count; line++) {
+        store.push_line(make_line(line));
+    }
+    auto resident_bytes = store.get_resident_bytes();
+    store.set_memory_cap(resident_bytes / 3);
+    // with a spill file nothing is dropped.
+    check(store.get_resident_bytes() <= resident_bytes / 3);
+    check(store.get_spilled_bytes() > 0);
+    check(store.get_dropped_line_count() == 0 && store.get_line_count() == line_count);
+    std::vector<terminal_cell> cells(40);
+    for (size_t line = 0; line < line_count; line++) {
+        store.copy_line(line, cells);
+        check(cells == make_line(line));
+    }
+    check(std::filesystem::is_empty(directory));
+}
+
+int main() {
+    auto directory = create_test_directory();
+    test_append_and_read(directory);
+    test_missing_directory(directory);
+    test_scrollback_spill(directory);
+    std::filesystem::remove_all(directory);
+}
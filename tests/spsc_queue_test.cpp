@@ -0,0 +1,58 @@
+#include "spsc_queue.hpp"
+#include "check.hpp"
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+static void test_order_and_wrap_around() {
+    spsc_queue<uint32_t, 8> queue;
+    uint32_t next_push = 0;
+    uint32_t next_pop = 0;
+    // more than the capacity goes through, so the indices wrap around.
+    for (int round = 0; round < 10; round++) {
+        std::vector<uint32_t> values{ next_push, next_push + 1, next_push + 2, next_push + 3, next_push + 4 };
+        check(queue.try_push(values) == values.size());
+        next_push += static_cast<uint32_t>(values.size());
+        auto count = queue.pop_all([&next_pop](uint32_t value) { check(value == next_pop++); });
+        check(count == values.size());
+        check(queue.empty());
+    }
+}
+
+static void test_full_queue() {
+    spsc_queue<uint32_t, 4> queue;
+    std::vector<uint32_t> values{ 0, 1, 2, 3, 4, 5 };
+    check(queue.try_push(values) == 4);
+    check(!queue.try_push(uint32_t{ 6 }));
+    uint32_t next_pop = 0;
+    check(queue.pop_all([&next_pop](uint32_t value) { check(value == next_pop++); }) == 4);
+    check(queue.try_push(std::span{ values }.subspan(4)) == 2);
+    check(queue.pop_all([&next_pop](uint32_t value) { check(value == next_pop++); }) == 2);
+    check(queue.pop_all([](uint32_t) { check(false); }) == 0);
+}
+
+static void test_threads() {
+    constexpr uint32_t value_count = 1 << 18;
+    spsc_queue<uint32_t, 1024> queue;
+    std::jthread producer{ [&queue]() {
+        std::vector<uint32_t> batch;
+        for (uint32_t next = 0; next < value_count;) {
+            batch.clear();
+            for (uint32_t i = 0; i < 100 && next + i < value_count; i++) {
+                batch.push_back(next + i);
+            }
+            next += static_cast<uint32_t>(queue.try_push(batch));
+        }
+    } };
+    uint32_t next_pop = 0;
+    while (next_pop < value_count) {
+        queue.pop_all([&next_pop](uint32_t value) { check(value == next_pop++); });
+    }
+}
+
+int main() {
+    test_order_and_wrap_around();
+    test_full_queue();
+    test_threads();
+}
@@ -0,0 +1,30 @@
+#include "terminal_cell.hpp"
+#include "check.hpp"
+
+#include <cstdint>
+
+static void test_glyph_index_round_trip() {
+    // indices past the old 12 bit field must not wrap.
+    for (uint32_t glyph_index : { 0u, 0xfffu, 0x1000u, 0x12345u, 0xffffffffu }) {
+        auto cell = packed_cell{ glyph_index, 0xf, 0xffffff, 0xffffff };
+        check(cell.get_glyph_index() == glyph_index);
+        check(cell.get_style() == 0xf);
+        check(cell.get_foreground() == 0xffffff);
+        check(cell.get_background() == 0xffffff);
+    }
+}
+
+static void test_pack_cell() {
+    auto cell = terminal_cell{ 'a', cell_color::palette(9), cell_color::rgb(0x12, 0x34, 0x56), eUnderline | eInverse };
+    auto packed = pack_cell(cell, 0x10000);
+    check(packed.get_glyph_index() == 0x10000);
+    // inverse swaps the colors, and with them the palette bits.
+    check(packed.get_foreground() == 0x123456);
+    check(packed.get_background() == 9);
+    check(packed.get_style() == (eUnderline | eBackgroundPalette));
+}
+
+int main() {
+    test_glyph_index_round_trip();
+    test_pack_cell();
+}
@@ -0,0 +1,180 @@
+#include "update_recording.hpp"
+#include "check.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+static std::filesystem::path get_test_path(const std::string& name) {
+    return std::filesystem::temp_directory_path() / (name + "_" + std::to_string(std::random_device{}()) + ".tur");
+}
+
+static void write_file(const std::filesystem::path& path, const std::vector<uint8_t>& data) {
+    std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+}
+
+static bool read_throws(const std::filesystem::path& path) {
+    try {
+        read_update_recording(path);
+    }
+    catch (const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+// applies the runs of every update read back, the grid must end up like the recorded one.
+static void apply(multidimention_vector<terminal_cell>& grid, const recorded_update& update) {
+    if (grid.get_width() != update.width || grid.get_height() != update.height) {
+        grid = multidimention_vector<terminal_cell>(update.width, update.height);
+    }
+    for (auto& run : update.runs) {
+        std::ranges::fill(grid.get_row(run.y).subspan(run.x, run.count), run.cell);
+    }
+}
+
+static bool equal(const multidimention_vector<terminal_cell>& a, const multidimention_vector<terminal_cell>& b) {
+    if (a.get_width() != b.get_width() || a.get_height() != b.get_height()) {
+        return false;
+    }
+    for (size_t y = 0; y < a.get_height(); y++) {
+        if (!std::ranges::equal(a.get_row(y), b.get_row(y))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void test_round_trip() {
+    auto path = get_test_path("update_recording_test");
+    multidimention_vector<terminal_cell> grid{ 6, 3 };
+    std::vector<multidimention_vector<terminal_cell>> recorded;
+    {
+        update_recorder recorder{ path };
+        grid.get_row(1)[2] = terminal_cell{ 'a', cell_color::palette(3), cell_color::rgb(1, 2, 3), eInverse };
+        // the first update of a pane stores every row.
+        recorder.record(0, grid, { false, false, false });
+        recorded.push_back(grid);
+        grid.get_row(2)[5].character = 0x1f600;
+        recorder.record(0, grid, { false, false, true });
+        recorded.push_back(grid);
+        // nothing dirty, nothing recorded.
+        recorder.record(0, grid, { false, false, false });
+        grid = multidimention_vector<terminal_cell>{ 3, 2 };
+        grid.get_row(0)[0].character = 'b';
+        recorder.record(0, grid, {});
+        recorded.push_back(grid);
+        recorder.record(7, grid, {});
+    }
+    auto updates = read_update_recording(path);
+    std::filesystem::remove(path);
+    check(updates.size() == 4);
+    check(updates[0].runs.size() == 5);
+    check(updates[1].runs.size() == 2 && updates[1].runs[0].y == 2 && updates[1].runs[1].x == 5);
+    check(updates[2].width == 3 && updates[2].height == 2 && updates[2].runs.size() == 3);
+    check(updates[3].pane == 7);
+    for (size_t i = 1; i < updates.size(); i++) {
+        check(updates[i].time >= updates[i - 1].time);
+    }
+    multidimention_vector<terminal_cell> replayed{};
+    for (size_t i = 0; i < 3; i++) {
+        check(updates[i].pane == 0);
+        apply(replayed, updates[i]);
+        check(equal(replayed, recorded[i]));
+    }
+}
+
+static void test_corrupt_recordings() {
+    auto path = get_test_path("update_recording_test_corrupt");
+    check(read_throws(path));
+    write_file(path, { 'T', 'U', 'R', 0 });
+    check(read_throws(path));
+    std::vector<uint8_t> valid{ update_recording_header.begin(), update_recording_header.end() };
+    write_file(path, valid);
+    check(read_update_recording(path).empty());
+    // time, pane, width, height, run count and a truncated run.
+    auto truncated = valid;
+    truncated.insert(truncated.end(), { 1, 0, 4, 4, 1, 0, 0, 4 });
+    write_file(path, truncated);
+    check(read_throws(path));
+    // a run count that does not fit into the file is not allocated.
+    auto huge_run_count = valid;
+    huge_run_count.insert(huge_run_count.end(), { 1, 0, 4, 4, 0xff, 0xff, 0xff, 0xff, 0x0f });
+    write_file(path, huge_run_count);
+    check(read_throws(path));
+    // a varint longer than 64 bits.
+    auto long_varint = valid;
+    long_varint.insert(long_varint.end(), 10, 0x80);
+    long_varint.push_back(0);
+    write_file(path, long_varint);
+    check(read_throws(path));
+    std::filesystem::remove(path);
+}
+
+// stands in for renderer_presenter, a frame applies what the queue holds to the grids.
+class fake_presenter {
+public:
+    fake_presenter(std::span<multidimention_vector<terminal_cell>* const> grids) : m_grids{ grids }, m_frames{} {}
+    cell_update_queue& get_update_queue() {
+        return m_queue;
+    }
+    uint64_t get_upload_count() const {
+        return 0;
+    }
+    std::chrono::nanoseconds get_last_frame_work_time() const {
+        return std::chrono::microseconds{ 1 };
+    }
+    void run() {
+        m_queue.pop_all([this](const cell_update& update) {
+            std::ranges::fill(m_grids[update.pane]->get_row(update.y).subspan(update.x, update.count), update.cell);
+            });
+        m_frames++;
+    }
+    uint64_t get_frame_count() const {
+        return m_frames;
+    }
+private:
+    cell_update_queue m_queue;
+    std::span<multidimention_vector<terminal_cell>* const> m_grids;
+    uint64_t m_frames;
+};
+
+static void test_replay() {
+    std::vector<recorded_update> updates;
+    // more runs than the queue holds, the writer needs extra frames to drain them.
+    constexpr auto large_height = static_cast<uint32_t>(cell_update_queue::capacity() + 10);
+    auto& large = updates.emplace_back(recorded_update{ {}, 1, 4, large_height, {} });
+    for (uint32_t y = 0; y < large_height; y++) {
+        large.runs.push_back(cell_update{ 1, 0, y, 4, terminal_cell{ y } });
+    }
+    updates.push_back(recorded_update{ {}, 0, 2, 2, { cell_update{ 0, 1, 1, 1, terminal_cell{ 'z' } } } });
+    multidimention_vector<terminal_cell> first{};
+    multidimention_vector<terminal_cell> second{};
+    std::array grids{ &first, &second };
+    fake_presenter presenter{ grids };
+    auto statistics = replay_update_recording(presenter, std::span{ grids }, updates, replay_speed::eAsFastAsPossible);
+    check(statistics.updates == 2 && statistics.frames == presenter.get_frame_count() && statistics.frames >= 3);
+    check(statistics.busy_time >= std::chrono::microseconds{ statistics.frames });
+    check(statistics.max_frame_time <= statistics.busy_time);
+    check(first.get_width() == 2 && first.get_row(1)[1].character == 'z' && first.get_row(0)[0] == terminal_cell{});
+    check(second.get_height() == large_height && second.get_row(large_height - 1)[3].character == large_height - 1);
+    // a pane without a grid.
+    updates.push_back(recorded_update{ {}, 2, 1, 1, {} });
+    bool thrown = false;
+    try {
+        replay_update_recording(presenter, std::span{ grids }, updates, replay_speed::eAsFastAsPossible);
+    }
+    catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    check(thrown);
+}
+
+int main() {
+    test_round_trip();
+    test_corrupt_recordings();
+    test_replay();
+}
@@ -0,0 +1,188 @@
+#include "vt_parser.hpp"
+#include "check.hpp"
+
+#include <random>
+#include <string>
+#include <vector>
+
+static std::string row_text(const grid_snapshot<terminal_cell>& snapshot, size_t y) {
+    std::string text;
+    for (auto& cell : snapshot.rows[y]->cells) {
+        text.push_back(cell.character < 0x80 ? static_cast<char>(cell.character) : '?');
+    }
+    return text;
+}
+
+static void check_rows(triple_buffered_grid<terminal_cell>& grid, const std::vector<std::string>& rows) {
+    auto& snapshot = grid.read();
+    check(snapshot.height == rows.size());
+    for (size_t y = 0; y < rows.size(); y++) {
+        check(row_text(snapshot, y) == rows[y]);
+    }
+}
+
+static void test_print_and_wrap() {
+    triple_buffered_grid<terminal_cell> grid{ 5, 3 };
+    vt_parser parser{ grid };
+    parser.feed("ab\r\ncdefgh");
+    check_rows(grid, { "ab   ", "cdefg", "h    " });
+    check(parser.get_cursor() == std::pair{ 1u, 2u });
+    // the last column is written without wrapping until the next character.
+    parser.feed("\r1234");
+    parser.feed("5");
+    check(parser.get_cursor() == std::pair{ 4u, 2u });
+    check_rows(grid, { "ab   ", "cdefg", "12345" });
+}
+
+static void test_scroll_and_scrollback() {
+    triple_buffered_grid<terminal_cell> grid{ 5, 3 };
+    scrollback_store scrollback{};
+    vt_parser parser{ grid, &scrollback };
+    parser.feed("ab\r\ncd\r\nef\r\ngh");
+    check_rows(grid, { "cd   ", "ef   ", "gh   " });
+    check(scrollback.get_line_count() == 1);
+    std::vector<terminal_cell> line(5);
+    scrollback.copy_line(0, line);
+    check(line[0].character == 'a' && line[1].character == 'b');
+    // a scroll region, its scrolls do not reach the scrollback.
+    parser.feed("\x1b[2;3r\x1b[3;1H\nXY");
+    check_rows(grid, { "cd   ", "gh   ", "XY   " });
+    check(scrollback.get_line_count() == 1);
+    // reverse index at the top scrolls down.
+    parser.feed("\x1b[r\x1b[1;1H\x1bMZ");
+    check_rows(grid, { "Z    ", "cd   ", "gh   " });
+    parser.feed("\x1b[2;1H\x1b[L");
+    check_rows(grid, { "Z    ", "     ", "cd   " });
+    parser.feed("\x1b[M\x1b[M");
+    check_rows(grid, { "Z    ", "     ", "     " });
+}
+
+static void test_erase_and_edit() {
+    triple_buffered_grid<terminal_cell> grid{ 6, 2 };
+    vt_parser parser{ grid };
+    parser.feed("abcdef\r\nghijkl");
+    parser.feed("\x1b[1;3H\x1b[K");
+    check_rows(grid, { "ab    ", "ghijkl" });
+    parser.feed("\x1b[2;3H\x1b[2@");
+    check_rows(grid, { "ab    ", "gh  ij" });
+    parser.feed("\x1b[3P");
+    check_rows(grid, { "ab    ", "ghj   " });
+    parser.feed("\x1b[2;2H\x1b[1K");
+    check_rows(grid, { "ab    ", "  j   " });
+    parser.feed("\x1b[2J");
+    check_rows(grid, { "      ", "      " });
+}
+
+static void test_attributes_and_utf8() {
+    triple_buffered_grid<terminal_cell> grid{ 8, 1 };
+    vt_parser parser{ grid };
+    parser.feed("\x1b[4;31;48;2;1;2;3ma\x1b[0mb");
+    // a sequence split between feeds and invalid UTF-8.
+    parser.feed("\xe4\xb8");
+    parser.feed("\xad\xc3(\xed\xa0\x80");
+    auto& snapshot = grid.read();
+    auto a = snapshot[{ 0, 0 }];
+    check(a.character == 'a' && a.style == eUnderline);
+    check(a.foreground == cell_color::palette(1) && a.background == cell_color::rgb(1, 2, 3));
+    check(snapshot[{ 1, 0 }] == (terminal_cell{ 'b' }));
+    check(snapshot[{ 2, 0 }].character == 0x4e2d);
+    check(snapshot[{ 3, 0 }].character == 0xfffd && snapshot[{ 4, 0 }].character == '(');
+    // a surrogate is decoded and replaced by one character.
+    check(snapshot[{ 5, 0 }].character == 0xfffd && snapshot[{ 6, 0 }].character == ' ');
+}
+
+static void test_title_cursor_and_reset() {
+    triple_buffered_grid<terminal_cell> grid{ 4, 2 };
+    vt_parser parser{ grid };
+    parser.feed("\x1b]2;first\x07\x1b]0;sec");
+    parser.feed("ond\x1b\\\x1b[?25l");
+    check(parser.get_title() == "second");
+    check(!parser.is_cursor_visible());
+    parser.feed("ab\x1b" "c");
+    check(parser.get_title().empty() && parser.is_cursor_visible());
+    check(parser.get_cursor() == std::pair{ 0u, 0u });
+    check_rows(grid, { "    ", "    " });
+}
+
+static void test_dirty_rows() {
+    triple_buffered_grid<terminal_cell> grid{ 4, 3 };
+    vt_parser parser{ grid };
+    parser.clear_dirty_rows();
+    parser.feed("\x1b[2;1Hx");
+    check(parser.get_dirty_rows() == std::vector<bool>{ false, true, false });
+    // only the written row gets a new version.
+    auto& before = grid.read();
+    auto versions = std::vector{ before.rows[0]->version, before.rows[1]->version, before.rows[2]->version };
+    parser.feed("y");
+    auto& after = grid.read();
+    check(after.rows[0]->version == versions[0] && after.rows[1]->version != versions[1] && after.rows[2]->version == versions[2]);
+}
+
+// bytes a parser is likely to get wrong: controls, sequence introducers, parameters and broken UTF-8.
+static std::string make_random_bytes(std::mt19937& random, size_t size) {
+    static constexpr std::string_view interesting = "\x1b[]?;0123456789\x07\x08\x09\x0a\x0d\x18\x1a\x9b\xc3\xe4\xf0\x80\xbf"
+        "ABCDEFGHJKLMPSTXdfmrsu@`cDEM78\\P^_";
+    std::string bytes;
+    for (size_t i = 0; i < size; i++) {
+        auto choice = random() % 4;
+        bytes.push_back(choice == 0 ? static_cast<char>(random() % 256)
+            : choice == 1 ? static_cast<char>(0x20 + random() % 0x5f) : interesting[random() % interesting.size()]);
+    }
+    return bytes;
+}
+
+static void check_snapshot(triple_buffered_grid<terminal_cell>& grid, const vt_parser& parser) {
+    auto& snapshot = grid.read();
+    check(snapshot.width == grid.get_width() && snapshot.height == grid.get_height());
+    check(snapshot.rows.size() == snapshot.height);
+    for (auto& row : snapshot.rows) {
+        check(row->cells.size() == snapshot.width);
+    }
+    auto [x, y] = parser.get_cursor();
+    check(snapshot.width == 0 || snapshot.height == 0 || (x < snapshot.width && y < snapshot.height));
+}
+
+// random input with resizes in between, run under the sanitizers; and the same bytes fed at once or in
+// random pieces must give the same screen.
+static void test_fuzz() {
+    std::mt19937 random{ 49 };
+    scrollback_store scrollback{ 1024 * 1024 };
+    triple_buffered_grid<terminal_cell> grid{ 10, 5 };
+    vt_parser parser{ grid, &scrollback };
+    for (int i = 0; i < 20000; i++) {
+        if (random() % 50 == 0) {
+            grid.resize(random() % 30, random() % 12);
+        }
+        parser.feed(make_random_bytes(random, random() % 64));
+        check_snapshot(grid, parser);
+    }
+    for (int i = 0; i < 200; i++) {
+        auto bytes = make_random_bytes(random, 512);
+        triple_buffered_grid<terminal_cell> whole_grid{ 12, 6 };
+        vt_parser whole{ whole_grid };
+        whole.feed(bytes);
+        triple_buffered_grid<terminal_cell> pieces_grid{ 12, 6 };
+        vt_parser pieces{ pieces_grid };
+        for (size_t offset = 0; offset < bytes.size();) {
+            auto size = std::min<size_t>(1 + random() % 16, bytes.size() - offset);
+            pieces.feed(std::string_view{ bytes }.substr(offset, size));
+            offset += size;
+        }
+        check(whole.get_cursor() == pieces.get_cursor() && whole.get_title() == pieces.get_title());
+        auto& whole_snapshot = whole_grid.read();
+        auto& pieces_snapshot = pieces_grid.read();
+        for (size_t y = 0; y < whole_snapshot.height; y++) {
+            check(whole_snapshot.rows[y]->cells == pieces_snapshot.rows[y]->cells);
+        }
+    }
+}
+
+int main() {
+    test_print_and_wrap();
+    test_scroll_and_scrollback();
+    test_erase_and_edit();
+    test_attributes_and_utf8();
+    test_title_cursor_and_reset();
+    test_dirty_rows();
+    test_fuzz();
+}
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "terminal_cell.hpp"
+#include "multidimention_array.hpp"
+#include "cell_update_queue.hpp"
+
+// Update recording file:
+//   header: "TUR" version byte
+//   update: time delta in microseconds, pane, width, height, run count, runs
+//   run:    y, x, count, character, foreground, background, style
+// every field is an unsigned LEB128 varint, colors are value << 1 | is_palette.
+// A run sets count cells of row y from column x, the rows of an update are stored whole.
+inline constexpr std::array<uint8_t, 4> update_recording_header{ 'T', 'U', 'R', 1 };
+
+// the rows of one pane the renderer was told about, time is counted from the start of the recording.
+struct recorded_update {
+    std::chrono::microseconds time;
+    uint32_t pane;
+    uint32_t width;
+    uint32_t height;
+    std::vector<cell_update> runs;
+};
+
+// Records what is fed to the renderer, like the rows a vt_parser marked dirty, so a session can be replayed
+// against another version of the renderer. The first update of a pane and every resize store all rows.
+class update_recorder {
+public:
+    update_recorder(std::filesystem::path path)
+        : m_file{ path, std::ios::binary | std::ios::trunc }, m_start{ std::chrono::steady_clock::now() }, m_last_time{} {
+        if (!m_file) {
+            throw std::runtime_error{ "failed to open update recording" };
+        }
+        m_file.write(reinterpret_cast<const char*>(update_recording_header.data()), update_recording_header.size());
+    }
+    // equal neighbouring cells of a row become one run.
+    void record(uint32_t pane, const multidimention_vector<terminal_cell>& grid, const std::vector<bool>& dirty_rows) {
+        auto size = std::pair{ grid.get_width(), grid.get_height() };
+        auto [pane_size, inserted] = m_pane_sizes.try_emplace(pane, size);
+        bool all_rows = inserted || pane_size->second != size;
+        pane_size->second = size;
+        auto time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_start);
+        std::vector<cell_update> runs;
+        for (size_t y = 0; y < grid.get_height(); y++) {
+            if (!all_rows && (y >= dirty_rows.size() || !dirty_rows[y])) {
+                continue;
+            }
+            auto row = grid.get_row(y);
+            for (size_t x = 0; x < row.size();) {
+                auto end = std::find_if(row.begin() + x, row.end(), [&cell = row[x]](auto& other) { return other != cell; });
+                auto count = static_cast<size_t>(end - row.begin()) - x;
+                runs.emplace_back(cell_update{ pane, static_cast<uint32_t>(x), static_cast<uint32_t>(y), static_cast<uint32_t>(count), row[x] });
+                x += count;
+            }
+        }
+        if (runs.empty()) {
+            return;
+        }
+        m_buffer.clear();
+        write_varint(static_cast<uint64_t>((time - m_last_time).count()));
+        write_varint(pane);
+        write_varint(grid.get_width());
+        write_varint(grid.get_height());
+        write_varint(runs.size());
+        for (auto& run : runs) {
+            write_varint(run.y);
+            write_varint(run.x);
+            write_varint(run.count);
+            write_varint(run.cell.character);
+            write_varint(encode_color(run.cell.foreground));
+            write_varint(encode_color(run.cell.background));
+            write_varint(run.cell.style);
+        }
+        m_file.write(reinterpret_cast<const char*>(m_buffer.data()), m_buffer.size());
+        m_last_time = time;
+    }
+private:
+    static uint64_t encode_color(cell_color color) {
+        return uint64_t{ color.get_value() } << 1 | (color.is_palette() ? 1 : 0);
+    }
+    void write_varint(uint64_t value) {
+        while (value >= 0x80) {
+            m_buffer.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        m_buffer.push_back(static_cast<uint8_t>(value));
+    }
+    std::ofstream m_file;
+    std::chrono::steady_clock::time_point m_start;
+    std::chrono::microseconds m_last_time;
+    std::map<uint32_t, std::pair<size_t, size_t>> m_pane_sizes;
+    std::vector<uint8_t> m_buffer;
+};
+
+inline std::vector<recorded_update> read_update_recording(const std::filesystem::path& path) {
+    std::ifstream file{ path, std::ios::binary };
+    if (!file) {
+        throw std::runtime_error{ "failed to open update recording" };
+    }
+    std::vector<uint8_t> data{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+    if (data.size() < update_recording_header.size() ||
+        !std::equal(update_recording_header.begin(), update_recording_header.end(), data.begin())) {
+        throw std::runtime_error{ "not an update recording of this version" };
+    }
+    size_t offset = update_recording_header.size();
+    auto read_varint = [&data, &offset]() {
+        uint64_t value = 0;
+        for (uint32_t shift = 0; shift < 64; shift += 7) {
+            if (offset == data.size()) {
+                throw std::runtime_error{ "truncated update recording" };
+            }
+            auto byte = data[offset++];
+            value |= uint64_t{ byte & 0x7fu } << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        throw std::runtime_error{ "corrupt update recording" };
+    };
+    auto read_u32 = [&read_varint]() {
+        return static_cast<uint32_t>(read_varint());
+    };
+    auto read_color = [&read_varint]() {
+        auto value = read_varint();
+        return (value & 1) ? cell_color::palette(static_cast<uint8_t>(value >> 1))
+            : cell_color::rgb(static_cast<uint8_t>(value >> 17), static_cast<uint8_t>(value >> 9), static_cast<uint8_t>(value >> 1));
+    };
+    std::vector<recorded_update> updates;
+    auto time = std::chrono::microseconds{};
+    while (offset < data.size()) {
+        time += std::chrono::microseconds{ read_varint() };
+        auto& update = updates.emplace_back(recorded_update{ time, read_u32(), read_u32(), read_u32(), {} });
+        // every field of a run takes at least a byte.
+        auto run_count = read_varint();
+        if (run_count > (data.size() - offset) / 7) {
+            throw std::runtime_error{ "corrupt update recording" };
+        }
+        update.runs.resize(run_count);
+        for (auto& run : update.runs) {
+            run.pane = update.pane;
+            run.y = read_u32();
+            run.x = read_u32();
+            run.count = read_u32();
+            run.cell.character = read_u32();
+            run.cell.foreground = read_color();
+            run.cell.background = read_color();
+            run.cell.style = read_u32();
+        }
+    }
+    return updates;
+}
+
+enum class replay_speed {
+    // one frame per update, nothing is waited for.
+    eAsFastAsPossible,
+    // waits for the recorded time of each update, the updates that are due by then share a frame.
+    eRealTime,
+};
+
+struct replay_statistics {
+    uint64_t updates;
+    uint64_t frames;
+    // full uploads of the glyph atlas and cell buffers, for new glyphs or sizes.
+    uint64_t uploads;
+    // includes the waits for vsync of a FIFO swapchain and those of eRealTime.
+    std::chrono::nanoseconds wall_time;
+    // spent writing updates and in the frames' get_last_frame_work_time, what the renderer costs without vsync.
+    std::chrono::nanoseconds busy_time;
+    std::chrono::nanoseconds max_frame_time;
+
+    std::chrono::nanoseconds get_time_per_update() const {
+        return updates > 0 ? busy_time / static_cast<int64_t>(updates) : std::chrono::nanoseconds{};
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& out, const replay_statistics& statistics) {
+    auto to_ms = [](std::chrono::nanoseconds time) { return std::chrono::duration<double, std::milli>(time).count(); };
+    return out << statistics.updates << " updates, " << statistics.frames << " frames, " << statistics.uploads << " uploads, "
+        << to_ms(statistics.wall_time) << " ms wall, " << to_ms(statistics.busy_time) << " ms busy, "
+        << to_ms(statistics.get_time_per_update()) << " ms per update, " << to_ms(statistics.max_frame_time) << " ms max frame";
+}
+
+// Pushes a recording through a presenter the way the parser thread would, through its cell update queue,
+// and runs the frames from this thread, so it is not for a started threaded_presenter. grids[pane] is the
+// terminal_buffer of each pane, a recorded resize replaces it and the next frame uploads everything.
+// Frame times are the presenter's get_last_frame_work_time, acquire and present block on the display.
+template<class Presenter>
+replay_statistics replay_update_recording(Presenter& presenter, std::span<multidimention_vector<terminal_cell>* const> grids,
+    const std::vector<recorded_update>& updates, replay_speed speed) {
+    using clock = std::chrono::steady_clock;
+    auto statistics = replay_statistics{};
+    auto first_upload_count = presenter.get_upload_count();
+    cell_update_writer writer{ presenter.get_update_queue() };
+    auto start = clock::now();
+    for (size_t i = 0; i < updates.size();) {
+        if (speed == replay_speed::eRealTime) {
+            std::this_thread::sleep_until(start + updates[i].time);
+        }
+        auto write_start = clock::now();
+        do {
+            auto& update = updates[i++];
+            if (update.pane >= grids.size()) {
+                throw std::runtime_error{ "update recording pane has no grid" };
+            }
+            auto& grid = *grids[update.pane];
+            if (grid.get_width() != update.width || grid.get_height() != update.height) {
+                grid = multidimention_vector<terminal_cell>(update.width, update.height);
+            }
+            for (auto& run : update.runs) {
+                writer.fill(run.pane, run.x, run.y, run.count, run.cell);
+            }
+            statistics.updates++;
+        } while (speed == replay_speed::eRealTime && i < updates.size() && clock::now() >= start + updates[i].time);
+        std::chrono::nanoseconds frame_time = clock::now() - write_start;
+        // a full queue is drained by an extra frame.
+        while (!writer.flush()) {
+            presenter.run();
+            frame_time += presenter.get_last_frame_work_time();
+            statistics.frames++;
+        }
+        presenter.run();
+        frame_time += presenter.get_last_frame_work_time();
+        statistics.frames++;
+        statistics.busy_time += frame_time;
+        statistics.max_frame_time = std::max<std::chrono::nanoseconds>(statistics.max_frame_time, frame_time);
+    }
+    statistics.wall_time = clock::now() - start;
+    statistics.uploads = presenter.get_upload_count() - first_upload_count;
+    return statistics;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "vulkan_utility.hpp"
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+
+// Runs uploads on a dedicated transfer queue family when the device has one, otherwise on the graphics
+// queue. Every upload signals the next value of a timeline semaphore. The graphics queue waits for an
+// upload's value only where it acquires the uploaded resource, and the CPU never waits for uploads
+// except on destruction. Acquires signal a value of the graphics queue's own timeline, so each timeline
+// is only signaled by one queue and its values arrive in order.
+// Its mutex guards every queue of the device, the presenters sharing it submit and present under lock_queues.
+class upload_queue {
+public:
+    upload_queue(vk::SharedDevice device, uint32_t graphics_queue_family_index, std::optional<uint32_t> transfer_queue_family_index)
+        : m_device{ device },
+        m_graphics_queue_family_index{ graphics_queue_family_index },
+        m_queue_family_index{ transfer_queue_family_index.value_or(graphics_queue_family_index) },
+        m_queue{ device->getQueue(m_queue_family_index, 0) },
+        m_command_pool{ vulkan::shared::create_command_pool(device, m_queue_family_index) },
+        m_graphics_command_pool{ vulkan::shared::create_command_pool(device, graphics_queue_family_index) },
+        m_timeline{ vulkan::create_timeline_semaphore(*device), device },
+        m_last_value{ 0 } {}
+    upload_queue(const upload_queue&) = delete;
+    upload_queue& operator=(const upload_queue&) = delete;
+    ~upload_queue() {
+        for (auto& submission : m_pending) {
+            auto res = m_device->waitSemaphores(
+                vk::SemaphoreWaitInfo{}.setSemaphores(*submission.semaphore).setValues(submission.value), UINT64_MAX);
+            assert(res == vk::Result::eSuccess);
+        }
+        collect_finished();
+    }
+    // resources recorded on another family have to be released by the upload and acquired by graphics.
+    bool is_dedicated() const {
+        return m_queue_family_index != m_graphics_queue_family_index;
+    }
+    uint32_t get_queue_family_index() const {
+        return m_queue_family_index;
+    }
+    uint32_t get_graphics_queue_family_index() const {
+        return m_graphics_queue_family_index;
+    }
+    // records the upload with record(cmd) and submits it, keep_alive is released once it finished.
+    // returns the timeline value signaled when the upload is done.
+    uint64_t submit(std::function<void(vk::CommandBuffer)> record, std::shared_ptr<void> keep_alive) {
+        std::lock_guard lock{ m_mutex };
+        auto value = ++m_last_value;
+        submit(m_queue, *m_command_pool, std::nullopt, m_timeline, value, record, std::move(keep_alive));
+        return value;
+    }
+    // records the graphics side of ownership transfers with record(cmd) and submits it on graphics_queue behind
+    // upload_value, signaling signal_value of the graphics queue's timeline. Only needed when is_dedicated(),
+    // the graphics family owns everything otherwise.
+    void acquire(vk::Queue graphics_queue, uint64_t upload_value, std::function<void(vk::CommandBuffer)> record,
+        vk::SharedSemaphore graphics_timeline, uint64_t signal_value) {
+        assert(is_dedicated());
+        std::lock_guard lock{ m_mutex };
+        submit(graphics_queue, *m_graphics_command_pool, upload_value, graphics_timeline, signal_value, record, nullptr);
+    }
+    // value of the last upload that finished.
+    uint64_t get_completed_value() const {
+        return m_device->getSemaphoreCounterValue(*m_timeline);
+    }
+    // a queue may not be used by two threads at once, held around each submit and present on the device.
+    std::unique_lock<std::mutex> lock_queues() {
+        return std::unique_lock{ m_mutex };
+    }
+private:
+    struct pending_submission {
+        // kept alive for the queries, the graphics timeline belongs to a presenter that may go first.
+        vk::SharedSemaphore semaphore;
+        uint64_t value;
+        vk::CommandPool command_pool;
+        vk::CommandBuffer command_buffer;
+        std::shared_ptr<void> keep_alive;
+    };
+    void submit(vk::Queue queue, vk::CommandPool command_pool, std::optional<uint64_t> upload_value,
+        vk::SharedSemaphore signal_semaphore, uint64_t signal_value,
+        std::function<void(vk::CommandBuffer)>& record, std::shared_ptr<void> keep_alive) {
+        collect_finished();
+        auto command_buffer = m_device->allocateCommandBuffers(
+            vk::CommandBufferAllocateInfo{}.setCommandPool(command_pool).setCommandBufferCount(1)).front();
+        command_buffer.begin(vk::CommandBufferBeginInfo{}.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+        record(command_buffer);
+        command_buffer.end();
+        auto command_buffer_info = vk::CommandBufferSubmitInfo{}.setCommandBuffer(command_buffer);
+        auto wait_info = vk::SemaphoreSubmitInfo{}.setSemaphore(*m_timeline).setValue(upload_value.value_or(0))
+            .setStageMask(vk::PipelineStageFlagBits2::eAllCommands);
+        auto signal_info = vk::SemaphoreSubmitInfo{}.setSemaphore(*signal_semaphore).setValue(signal_value)
+            .setStageMask(vk::PipelineStageFlagBits2::eAllCommands);
+        auto submit_info = vk::SubmitInfo2{}.setCommandBufferInfos(command_buffer_info).setSignalSemaphoreInfos(signal_info);
+        if (upload_value) {
+            submit_info.setWaitSemaphoreInfos(wait_info);
+        }
+        queue.submit2(submit_info);
+        m_pending.emplace_back(pending_submission{
+            signal_semaphore, signal_value, command_pool, command_buffer, std::move(keep_alive) });
+    }
+    // stops at the first unfinished submission, the ones behind it are freed by a later call.
+    void collect_finished() {
+        while (!m_pending.empty() &&
+            m_device->getSemaphoreCounterValue(*m_pending.front().semaphore) >= m_pending.front().value) {
+            auto& submission = m_pending.front();
+            m_device->freeCommandBuffers(submission.command_pool, submission.command_buffer);
+            m_pending.pop_front();
+        }
+    }
+    vk::SharedDevice m_device;
+    uint32_t m_graphics_queue_family_index;
+    uint32_t m_queue_family_index;
+    vk::Queue m_queue;
+    vk::SharedCommandPool m_command_pool;
+    vk::SharedCommandPool m_graphics_command_pool;
+    vk::SharedSemaphore m_timeline;
+    uint64_t m_last_value;
+    std::mutex m_mutex;
+    std::deque<pending_submission> m_pending;
+};
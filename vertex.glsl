@@ -1,11 +1,45 @@
 #version 460
+#extension GL_GOOGLE_include_directive : require
 
-layout(location=0) in vec4 vertex;
+#include "packed_cell.glsl"
+#include "pane_parameters.glsl"
+#include "glyph_rects.glsl"
 
-layout(location=0) out vec2 coord;
+// six vertices per cell, in row order of the pane.
+const vec2 corners[6] = vec2[](vec2(0,0), vec2(1,0), vec2(0,1), vec2(0,1), vec2(1,0), vec2(1,1));
+
+layout(std430, binding=1) readonly buffer cells_buffer {
+    uint cells[];
+};
+layout(std140, binding=2) uniform palette_colors {
+    vec4 colors[256];
+} palette;
+
+layout(location=0) flat out vec4 glyph_uv;
+layout(location=1) out vec2 cell_coord;
+layout(location=2) flat out vec3 foreground;
+layout(location=3) flat out vec3 background;
+layout(location=4) flat out uint style;
+layout(location=5) flat out vec4 glyph_box;
+layout(location=6) flat out uint glyph_layer;
+
+vec3 resolve_color(uint color, bool is_palette) {
+    return is_palette ? palette.colors[color & 0xffu].rgb : unpack_rgb(color);
+}
 
 void main() {
-    vec2 pos = vertex.xy;
+    uint cell_index = gl_VertexIndex / 6;
+    vec2 corner = corners[gl_VertexIndex % 6];
+    uvec3 cell = load_packed_cell(cells, pane.cell_offset + cell_index);
+    const vec2 grid_size = vec2(2.0) / vec2(pane.width, pane.visible_height);
+    vec2 pos = (vec2(cell_index % pane.width, cell_index / pane.width) + corner - pane.scroll_offset) * grid_size + vec2(-1.0, -1.0);
     gl_Position = vec4(pos, 0, 1);
-    coord = vertex.zw;
-}
\ No newline at end of file
+    glyph_rect glyph = glyph_rects[cell_glyph_index(cell)];
+    glyph_uv = glyph.uv;
+    glyph_box = glyph.box;
+    glyph_layer = glyph.layer;
+    cell_coord = corner;
+    style = cell_style(cell);
+    foreground = resolve_color(cell_foreground(cell), (style & cell_style_foreground_palette) != 0u);
+    background = resolve_color(cell_background(cell), (style & cell_style_background_palette) != 0u);
+}
@@ -0,0 +1,772 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VT_PARSER_SSE2
+#endif
+
+#include "terminal_cell.hpp"
+#include "grid_snapshot.hpp"
+#include "scrollback_store.hpp"
+
+// length of the run of printable ASCII bytes at the start of data, it ends at a C0 control, DEL or a UTF-8 byte.
+// the SSE2 path tests 16 bytes per step.
+inline size_t scan_printable_ascii(const uint8_t* data, size_t size) {
+    size_t i = 0;
+#ifdef VT_PARSER_SSE2
+    const auto space = _mm_set1_epi8(0x20);
+    const auto del = _mm_set1_epi8(0x7f);
+    for (; i + 16 <= size; i += 16) {
+        auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        // bytes from 0x80 on are negative as signed, the same compare finds controls and UTF-8.
+        auto special = _mm_or_si128(_mm_cmplt_epi8(bytes, space), _mm_cmpeq_epi8(bytes, del));
+        if (auto mask = static_cast<uint32_t>(_mm_movemask_epi8(special))) {
+            return i + std::countr_zero(mask);
+        }
+    }
+#endif
+    while (i < size && data[i] >= 0x20 && data[i] < 0x7f) {
+        i++;
+    }
+    return i;
+}
+
+// Turns the byte stream of a pty into cells of a grid: UTF-8, C0 controls, ESC, CSI and OSC sequences.
+// The state machine follows the DEC parser, unsupported sequences are consumed and ignored.
+// In the ground state, runs of printable ASCII are found by scan_printable_ascii and written row by row.
+// The grid is published once at the end of every feed, a renderer following it with attach_pane_snapshots
+// only repacks the rows whose version changed. Scrolls move rows instead of cells. Written rows are also
+// marked in get_dirty_rows, like for an update_recorder.
+// Characters are one cell wide. Lines scrolled off the top of the screen go to the scrollback if there is one.
+class vt_parser {
+public:
+    // the parser is the writer of grid, it runs on one thread and the renderer reads the snapshots.
+    vt_parser(triple_buffered_grid<terminal_cell>& grid, scrollback_store* scrollback = nullptr)
+        : m_grid{ grid }, m_scrollback{ scrollback } {
+        reset();
+        m_grid.publish();
+    }
+    void feed(std::string_view bytes) {
+        feed(std::span{ reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size() });
+    }
+    void feed(std::span<const uint8_t> bytes) {
+        sync_size();
+        size_t i = 0;
+        while (i < bytes.size()) {
+            if (m_state == state::eGround && m_utf8_remaining == 0) {
+                if (auto run = scan_printable_ascii(bytes.data() + i, bytes.size() - i)) {
+                    print_ascii(bytes.subspan(i, run));
+                    i += run;
+                    continue;
+                }
+            }
+            consume(bytes[i++]);
+        }
+        m_grid.publish();
+    }
+    // rows written since the last clear_dirty_rows.
+    const std::vector<bool>& get_dirty_rows() const {
+        return m_dirty_rows;
+    }
+    void clear_dirty_rows() {
+        std::fill(m_dirty_rows.begin(), m_dirty_rows.end(), false);
+    }
+    std::pair<uint32_t, uint32_t> get_cursor() const {
+        return { m_x, m_y };
+    }
+    bool is_cursor_visible() const {
+        return m_cursor_visible;
+    }
+    // set by OSC 0 and OSC 2.
+    const std::string& get_title() const {
+        return m_title;
+    }
+    // RIS, the grid is cleared and every row is dirty, published with the next feed.
+    void reset() {
+        m_state = state::eGround;
+        m_utf8_codepoint = 0;
+        m_utf8_remaining = 0;
+        m_utf8_min = 0;
+        m_params.fill(0);
+        m_param_count = 0;
+        m_private_marker = 0;
+        m_intermediate = 0;
+        m_string_escape = false;
+        m_attributes = terminal_cell{};
+        m_x = 0;
+        m_y = 0;
+        m_wrap_pending = false;
+        m_saved = saved_cursor{ 0, 0, m_attributes };
+        m_cursor_visible = true;
+        m_title.clear();
+        set_size(static_cast<uint32_t>(m_grid.get_width()), static_cast<uint32_t>(m_grid.get_height()));
+        erase(0, 0, m_width, m_height);
+    }
+private:
+    enum class state {
+        eGround,
+        eEscape,
+        eEscapeIntermediate,
+        eCsi,
+        eCsiIgnore,
+        eOsc,
+        // DCS, SOS, PM and APC strings are skipped up to their ST.
+        eString,
+    };
+    struct saved_cursor {
+        uint32_t x;
+        uint32_t y;
+        terminal_cell attributes;
+    };
+    static constexpr size_t max_params = 16;
+    static constexpr size_t max_osc_size = 4096;
+    static constexpr uint32_t replacement_character = 0xfffd;
+
+    // the owner may resize the grid between feeds, the cursor and the scroll region follow.
+    void sync_size() {
+        uint32_t width = static_cast<uint32_t>(m_grid.get_width());
+        uint32_t height = static_cast<uint32_t>(m_grid.get_height());
+        if (width != m_width || height != m_height) {
+            set_size(width, height);
+        }
+    }
+    void set_size(uint32_t width, uint32_t height) {
+        m_width = width;
+        m_height = height;
+        m_dirty_rows.assign(height, true);
+        m_scroll_top = 0;
+        m_scroll_bottom = height > 0 ? height - 1 : 0;
+        m_x = std::min(m_x, width > 0 ? width - 1 : 0);
+        m_y = std::min(m_y, height > 0 ? height - 1 : 0);
+        m_wrap_pending = false;
+    }
+    // a row still shared with a published snapshot is copied before it is written.
+    std::span<terminal_cell> get_row(uint32_t y) {
+        return m_grid.get_row(y);
+    }
+    std::span<const terminal_cell> read_row(uint32_t y) const {
+        return std::as_const(m_grid).get_row(y);
+    }
+    void consume(uint8_t c) {
+        if (c == 0x18 || c == 0x1a) {
+            m_state = state::eGround;
+            return;
+        }
+        switch (m_state) {
+        case state::eGround:
+            consume_ground(c);
+            break;
+        case state::eEscape:
+            consume_escape(c);
+            break;
+        case state::eEscapeIntermediate:
+            if (c == 0x1b) {
+                enter_escape();
+            }
+            else if (c < 0x20) {
+                execute(c);
+            }
+            else if (c >= 0x30 && c < 0x7f) {
+                // designations like ESC ( B, there is only one character set.
+                m_state = state::eGround;
+            }
+            break;
+        case state::eCsi:
+        case state::eCsiIgnore:
+            consume_csi(c);
+            break;
+        case state::eOsc:
+        case state::eString:
+            consume_string(c);
+            break;
+        }
+    }
+    void consume_ground(uint8_t c) {
+        if (c >= 0x80) {
+            consume_utf8(c);
+            return;
+        }
+        if (m_utf8_remaining > 0) {
+            m_utf8_remaining = 0;
+            print(replacement_character);
+        }
+        if (c == 0x1b) {
+            enter_escape();
+        }
+        else if (c < 0x20) {
+            execute(c);
+        }
+        else if (c < 0x7f) {
+            print(c);
+        }
+    }
+    // invalid and overlong sequences and surrogates become U+FFFD.
+    void consume_utf8(uint8_t c) {
+        if (m_utf8_remaining > 0) {
+            if ((c & 0xc0) == 0x80) {
+                m_utf8_codepoint = m_utf8_codepoint << 6 | (c & 0x3f);
+                if (--m_utf8_remaining == 0) {
+                    auto codepoint = m_utf8_codepoint;
+                    bool valid = codepoint >= m_utf8_min && codepoint <= 0x10ffff && (codepoint < 0xd800 || codepoint > 0xdfff);
+                    print(valid ? codepoint : replacement_character);
+                }
+                return;
+            }
+            m_utf8_remaining = 0;
+            print(replacement_character);
+        }
+        if (c >= 0xc2 && c <= 0xdf) {
+            m_utf8_codepoint = c & 0x1f;
+            m_utf8_remaining = 1;
+            m_utf8_min = 0x80;
+        }
+        else if (c >= 0xe0 && c <= 0xef) {
+            m_utf8_codepoint = c & 0x0f;
+            m_utf8_remaining = 2;
+            m_utf8_min = 0x800;
+        }
+        else if (c >= 0xf0 && c <= 0xf4) {
+            m_utf8_codepoint = c & 0x07;
+            m_utf8_remaining = 3;
+            m_utf8_min = 0x10000;
+        }
+        else {
+            print(replacement_character);
+        }
+    }
+    void enter_escape() {
+        m_state = state::eEscape;
+        m_intermediate = 0;
+    }
+    void consume_escape(uint8_t c) {
+        if (c == 0x1b) {
+            enter_escape();
+        }
+        else if (c < 0x20) {
+            execute(c);
+        }
+        else if (c < 0x30) {
+            m_intermediate = c;
+            m_state = state::eEscapeIntermediate;
+        }
+        else if (c == '[') {
+            m_state = state::eCsi;
+            m_params.fill(0);
+            m_param_count = 0;
+            m_private_marker = 0;
+            m_intermediate = 0;
+        }
+        else if (c == ']') {
+            m_state = state::eOsc;
+            m_string.clear();
+            m_string_escape = false;
+        }
+        else if (c == 'P' || c == 'X' || c == '^' || c == '_') {
+            m_state = state::eString;
+            m_string_escape = false;
+        }
+        else if (c < 0x7f) {
+            m_state = state::eGround;
+            escape_dispatch(c);
+        }
+    }
+    void consume_csi(uint8_t c) {
+        if (c == 0x1b) {
+            enter_escape();
+        }
+        else if (c < 0x20) {
+            execute(c);
+        }
+        else if (c >= 0x40 && c < 0x7f) {
+            if (m_state == state::eCsi) {
+                csi_dispatch(c);
+            }
+            m_state = state::eGround;
+        }
+        else if (m_state == state::eCsiIgnore) {
+        }
+        else if (c >= '0' && c <= '9' && m_intermediate == 0) {
+            if (m_param_count == 0) {
+                m_param_count = 1;
+            }
+            auto& param = m_params[m_param_count - 1];
+            param = std::min<uint32_t>(param * 10 + (c - '0'), 65535);
+        }
+        // sub-parameters of SGR colors are read like parameters.
+        else if ((c == ';' || c == ':') && m_intermediate == 0) {
+            if (m_param_count == 0) {
+                m_param_count = 1;
+            }
+            if (m_param_count < max_params) {
+                m_param_count++;
+            }
+        }
+        else if (c >= 0x3c && c <= 0x3f && m_param_count == 0 && m_private_marker == 0 && m_intermediate == 0) {
+            m_private_marker = c;
+        }
+        else if (c >= 0x20 && c < 0x30) {
+            m_intermediate = c;
+        }
+        else if (c != 0x7f) {
+            m_state = state::eCsiIgnore;
+        }
+    }
+    // an ESC inside the string is taken as ST, a byte other than '\' after it starts the next escape sequence.
+    void consume_string(uint8_t c) {
+        if (m_string_escape) {
+            m_string_escape = false;
+            if (m_state == state::eOsc) {
+                osc_dispatch();
+            }
+            m_state = state::eGround;
+            if (c != '\\') {
+                enter_escape();
+                consume_escape(c);
+            }
+            return;
+        }
+        if (c == 0x1b) {
+            m_string_escape = true;
+        }
+        else if (c == 0x07 && m_state == state::eOsc) {
+            osc_dispatch();
+            m_state = state::eGround;
+        }
+        else if (c >= 0x20 && m_state == state::eOsc && m_string.size() < max_osc_size) {
+            m_string.push_back(static_cast<char>(c));
+        }
+    }
+    void execute(uint8_t c) {
+        switch (c) {
+        case '\b':
+            m_x = m_x > 0 ? m_x - 1 : 0;
+            m_wrap_pending = false;
+            break;
+        case '\t':
+            if (m_width > 0) {
+                m_x = std::min((m_x / 8 + 1) * 8, m_width - 1);
+            }
+            m_wrap_pending = false;
+            break;
+        case '\n':
+        case '\v':
+        case '\f':
+            line_feed();
+            break;
+        case '\r':
+            m_x = 0;
+            m_wrap_pending = false;
+            break;
+        default:
+            break;
+        }
+    }
+    void escape_dispatch(uint8_t c) {
+        switch (c) {
+        case '7':
+            m_saved = saved_cursor{ m_x, m_y, m_attributes };
+            break;
+        case '8':
+            restore_cursor();
+            break;
+        case 'D':
+            line_feed();
+            break;
+        case 'E':
+            m_x = 0;
+            line_feed();
+            break;
+        case 'M':
+            reverse_index();
+            break;
+        case 'c':
+            reset();
+            break;
+        default:
+            break;
+        }
+    }
+    // 0 and missing parameters take the default.
+    uint32_t param(size_t index, uint32_t default_value) const {
+        return index < m_param_count && m_params[index] != 0 ? m_params[index] : default_value;
+    }
+    void csi_dispatch(uint8_t c) {
+        if (m_private_marker == '?') {
+            if ((c == 'h' || c == 'l') && m_intermediate == 0) {
+                for (size_t i = 0; i < m_param_count; i++) {
+                    if (m_params[i] == 25) {
+                        m_cursor_visible = c == 'h';
+                    }
+                }
+            }
+            return;
+        }
+        if (m_private_marker != 0 || m_intermediate != 0 || m_width == 0 || m_height == 0) {
+            return;
+        }
+        auto n = param(0, 1);
+        switch (c) {
+        case '@':
+            insert_cells(n);
+            break;
+        case 'A':
+            move_to(m_x, m_y >= m_scroll_top ? std::max<int64_t>(m_scroll_top, int64_t{ m_y } - n) : int64_t{ m_y } - n);
+            break;
+        case 'B':
+        case 'e':
+            move_to(m_x, m_y <= m_scroll_bottom ? std::min<int64_t>(m_scroll_bottom, int64_t{ m_y } + n) : int64_t{ m_y } + n);
+            break;
+        case 'C':
+        case 'a':
+            move_to(int64_t{ m_x } + n, m_y);
+            break;
+        case 'D':
+            move_to(int64_t{ m_x } - n, m_y);
+            break;
+        case 'E':
+            move_to(0, m_y <= m_scroll_bottom ? std::min<int64_t>(m_scroll_bottom, int64_t{ m_y } + n) : int64_t{ m_y } + n);
+            break;
+        case 'F':
+            move_to(0, m_y >= m_scroll_top ? std::max<int64_t>(m_scroll_top, int64_t{ m_y } - n) : int64_t{ m_y } - n);
+            break;
+        case 'G':
+        case '`':
+            move_to(int64_t{ n } - 1, m_y);
+            break;
+        case 'H':
+        case 'f':
+            move_to(int64_t{ param(1, 1) } - 1, int64_t{ n } - 1);
+            break;
+        case 'd':
+            move_to(m_x, int64_t{ n } - 1);
+            break;
+        case 'J':
+            erase_in_display(param(0, 0));
+            break;
+        case 'K':
+            erase_in_line(param(0, 0));
+            break;
+        case 'L':
+            if (m_y >= m_scroll_top && m_y <= m_scroll_bottom) {
+                scroll_down(m_y, m_scroll_bottom, n);
+                m_x = 0;
+                m_wrap_pending = false;
+            }
+            break;
+        case 'M':
+            if (m_y >= m_scroll_top && m_y <= m_scroll_bottom) {
+                scroll_up(m_y, m_scroll_bottom, n, false);
+                m_x = 0;
+                m_wrap_pending = false;
+            }
+            break;
+        case 'P':
+            delete_cells(n);
+            break;
+        case 'S':
+            scroll_up(m_scroll_top, m_scroll_bottom, n, false);
+            break;
+        case 'T':
+            scroll_down(m_scroll_top, m_scroll_bottom, n);
+            break;
+        case 'X':
+            erase(m_x, m_y, std::min(m_x + n, m_width), m_y + 1);
+            m_wrap_pending = false;
+            break;
+        case 'm':
+            select_graphic_rendition();
+            break;
+        case 'r':
+            set_scroll_region(param(0, 1) - 1, param(1, m_height) - 1);
+            break;
+        case 's':
+            m_saved = saved_cursor{ m_x, m_y, m_attributes };
+            break;
+        case 'u':
+            restore_cursor();
+            break;
+        default:
+            break;
+        }
+    }
+    // OSC 0 and 2 set the title, the other commands are ignored.
+    void osc_dispatch() {
+        auto separator = m_string.find(';');
+        if (separator == std::string::npos) {
+            return;
+        }
+        auto command = std::string_view{ m_string }.substr(0, separator);
+        if (command == "0" || command == "2") {
+            m_title = m_string.substr(separator + 1);
+        }
+    }
+    void select_graphic_rendition() {
+        auto default_cell = terminal_cell{};
+        if (m_param_count == 0) {
+            m_attributes = default_cell;
+            return;
+        }
+        // 38 and 48 take 5;index or 2;r;g;b.
+        auto extended_color = [this](size_t& i, cell_color& color) {
+            if (i + 2 < m_param_count && m_params[i + 1] == 5) {
+                color = cell_color::palette(static_cast<uint8_t>(m_params[i + 2]));
+                i += 2;
+            }
+            else if (i + 4 < m_param_count && m_params[i + 1] == 2) {
+                color = cell_color::rgb(static_cast<uint8_t>(m_params[i + 2]), static_cast<uint8_t>(m_params[i + 3]),
+                    static_cast<uint8_t>(m_params[i + 4]));
+                i += 4;
+            }
+            else {
+                i = m_param_count;
+            }
+        };
+        for (size_t i = 0; i < m_param_count; i++) {
+            auto p = m_params[i];
+            if (p == 0) {
+                m_attributes = default_cell;
+            }
+            else if (p == 4) {
+                m_attributes.style |= eUnderline;
+            }
+            else if (p == 7) {
+                m_attributes.style |= eInverse;
+            }
+            else if (p == 9) {
+                m_attributes.style |= eStrikethrough;
+            }
+            else if (p == 24) {
+                m_attributes.style &= ~eUnderline;
+            }
+            else if (p == 27) {
+                m_attributes.style &= ~eInverse;
+            }
+            else if (p == 29) {
+                m_attributes.style &= ~eStrikethrough;
+            }
+            else if (p >= 30 && p <= 37) {
+                m_attributes.foreground = cell_color::palette(static_cast<uint8_t>(p - 30));
+            }
+            else if (p == 38) {
+                extended_color(i, m_attributes.foreground);
+            }
+            else if (p == 39) {
+                m_attributes.foreground = default_cell.foreground;
+            }
+            else if (p >= 40 && p <= 47) {
+                m_attributes.background = cell_color::palette(static_cast<uint8_t>(p - 40));
+            }
+            else if (p == 48) {
+                extended_color(i, m_attributes.background);
+            }
+            else if (p == 49) {
+                m_attributes.background = default_cell.background;
+            }
+            else if (p >= 90 && p <= 97) {
+                m_attributes.foreground = cell_color::palette(static_cast<uint8_t>(p - 90 + 8));
+            }
+            else if (p >= 100 && p <= 107) {
+                m_attributes.background = cell_color::palette(static_cast<uint8_t>(p - 100 + 8));
+            }
+        }
+    }
+    // the cursor stays on the last column after writing it, the next character wraps first.
+    void print_ascii(std::span<const uint8_t> run) {
+        if (m_width == 0 || m_height == 0) {
+            return;
+        }
+        while (!run.empty()) {
+            if (m_wrap_pending) {
+                m_x = 0;
+                line_feed();
+            }
+            auto count = std::min<size_t>(run.size(), m_width - m_x);
+            auto cell = m_attributes;
+            std::ranges::transform(run.first(count), get_row(m_y).begin() + m_x, [&cell](uint8_t c) {
+                cell.character = c;
+                return cell;
+                });
+            m_dirty_rows[m_y] = true;
+            m_x += static_cast<uint32_t>(count);
+            if (m_x == m_width) {
+                m_x = m_width - 1;
+                m_wrap_pending = true;
+            }
+            run = run.subspan(count);
+        }
+    }
+    void print(uint32_t codepoint) {
+        if (m_width == 0 || m_height == 0) {
+            return;
+        }
+        if (m_wrap_pending) {
+            m_x = 0;
+            line_feed();
+        }
+        auto& cell = get_row(m_y)[m_x];
+        cell = m_attributes;
+        cell.character = codepoint;
+        m_dirty_rows[m_y] = true;
+        if (m_x + 1 == m_width) {
+            m_wrap_pending = true;
+        }
+        else {
+            m_x++;
+        }
+    }
+    void line_feed() {
+        m_wrap_pending = false;
+        if (m_height == 0) {
+            return;
+        }
+        if (m_y == m_scroll_bottom) {
+            scroll_up(m_scroll_top, m_scroll_bottom, 1, true);
+        }
+        else if (m_y + 1 < m_height) {
+            m_y++;
+        }
+    }
+    void reverse_index() {
+        m_wrap_pending = false;
+        if (m_height == 0) {
+            return;
+        }
+        if (m_y == m_scroll_top) {
+            scroll_down(m_scroll_top, m_scroll_bottom, 1);
+        }
+        else if (m_y > 0) {
+            m_y--;
+        }
+    }
+    void move_to(int64_t x, int64_t y) {
+        if (m_width == 0 || m_height == 0) {
+            return;
+        }
+        m_x = static_cast<uint32_t>(std::clamp<int64_t>(x, 0, m_width - 1));
+        m_y = static_cast<uint32_t>(std::clamp<int64_t>(y, 0, m_height - 1));
+        m_wrap_pending = false;
+    }
+    void restore_cursor() {
+        m_attributes = m_saved.attributes;
+        move_to(m_saved.x, m_saved.y);
+    }
+    void set_scroll_region(uint32_t top, uint32_t bottom) {
+        bottom = std::min(bottom, m_height - 1);
+        if (top < bottom) {
+            m_scroll_top = top;
+            m_scroll_bottom = bottom;
+            move_to(0, 0);
+        }
+    }
+    // erased cells keep the current colors, not the style.
+    terminal_cell get_blank() const {
+        return terminal_cell{ ' ', m_attributes.foreground, m_attributes.background, 0 };
+    }
+    // clears columns left..right of rows top..bottom, right and bottom excluded.
+    void erase(uint32_t left, uint32_t top, uint32_t right, uint32_t bottom) {
+        auto blank = get_blank();
+        for (auto y = top; y < bottom; y++) {
+            if (left == 0 && right == m_width) {
+                m_grid.fill_row(y, blank);
+            }
+            else {
+                std::ranges::fill(get_row(y).subspan(left, right - left), blank);
+            }
+            m_dirty_rows[y] = true;
+        }
+    }
+    void erase_in_display(uint32_t mode) {
+        if (mode == 0) {
+            erase(m_x, m_y, m_width, m_y + 1);
+            erase(0, m_y + 1, m_width, m_height);
+        }
+        else if (mode == 1) {
+            erase(0, 0, m_width, m_y);
+            erase(0, m_y, m_x + 1, m_y + 1);
+        }
+        else if (mode == 2 || mode == 3) {
+            erase(0, 0, m_width, m_height);
+        }
+    }
+    void erase_in_line(uint32_t mode) {
+        if (mode == 0) {
+            erase(m_x, m_y, m_width, m_y + 1);
+        }
+        else if (mode == 1) {
+            erase(0, m_y, m_x + 1, m_y + 1);
+        }
+        else if (mode == 2) {
+            erase(0, m_y, m_width, m_y + 1);
+        }
+    }
+    void insert_cells(uint32_t count) {
+        auto row = get_row(m_y).subspan(m_x);
+        count = std::min<uint32_t>(count, static_cast<uint32_t>(row.size()));
+        std::shift_right(row.begin(), row.end(), count);
+        std::ranges::fill(row.first(count), get_blank());
+        m_dirty_rows[m_y] = true;
+        m_wrap_pending = false;
+    }
+    void delete_cells(uint32_t count) {
+        auto row = get_row(m_y).subspan(m_x);
+        count = std::min<uint32_t>(count, static_cast<uint32_t>(row.size()));
+        std::shift_left(row.begin(), row.end(), count);
+        std::ranges::fill(row.last(count), get_blank());
+        m_dirty_rows[m_y] = true;
+        m_wrap_pending = false;
+    }
+    // moves rows top..bottom up by count, the rows leaving the top of the screen are kept in the scrollback.
+    void scroll_up(uint32_t top, uint32_t bottom, uint32_t count, bool keep_in_scrollback) {
+        count = std::min(count, bottom - top + 1);
+        if (keep_in_scrollback && m_scrollback && top == 0) {
+            for (uint32_t y = top; y < top + count; y++) {
+                m_scrollback->push_line(read_row(y));
+            }
+        }
+        m_grid.rotate_rows(top, top + count, bottom + 1);
+        erase(0, bottom + 1 - count, m_width, bottom + 1);
+        std::fill(m_dirty_rows.begin() + top, m_dirty_rows.begin() + bottom + 1, true);
+    }
+    void scroll_down(uint32_t top, uint32_t bottom, uint32_t count) {
+        count = std::min(count, bottom - top + 1);
+        m_grid.rotate_rows(top, bottom + 1 - count, bottom + 1);
+        erase(0, top, m_width, top + count);
+        std::fill(m_dirty_rows.begin() + top, m_dirty_rows.begin() + bottom + 1, true);
+    }
+
+    triple_buffered_grid<terminal_cell>& m_grid;
+    scrollback_store* m_scrollback;
+    std::vector<bool> m_dirty_rows;
+    uint32_t m_width;
+    uint32_t m_height;
+    state m_state;
+    uint32_t m_utf8_codepoint;
+    uint32_t m_utf8_remaining;
+    uint32_t m_utf8_min;
+    std::array<uint32_t, max_params> m_params;
+    size_t m_param_count;
+    uint8_t m_private_marker;
+    uint8_t m_intermediate;
+    std::string m_string;
+    bool m_string_escape;
+    terminal_cell m_attributes;
+    uint32_t m_x;
+    uint32_t m_y;
+    bool m_wrap_pending;
+    saved_cursor m_saved;
+    uint32_t m_scroll_top;
+    uint32_t m_scroll_bottom;
+    bool m_cursor_visible;
+    std::string m_title;
+};
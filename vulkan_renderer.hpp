@@ -4,8 +4,102 @@
 #define NOMINMAX
 #endif
 #include "vulkan_utility.hpp"
+#include "device_context.hpp"
+#include "upload_queue.hpp"
+#include "cell_update_queue.hpp"
+#include "grid_snapshot.hpp"
+#include "scrollback_store.hpp"
+#include "glyph_packer.hpp"
+#include "vt_parser.hpp"
+#include "update_recording.hpp"
 #include <vulkan_helper.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <variant>
+
+// push constants of pane_parameters.glsl.
+struct pane_push_constants {
+    uint32_t cell_offset;
+    uint32_t width;
+    uint32_t height;
+    uint32_t occupancy_offset;
+    std::array<float, 2> scroll_offset;
+    uint32_t visible_height;
+};
+// cell_occupancy.glsl, a task workgroup covers rows_per_task_workgroup rows and at most
+// max_occupancy_words_per_row words of each, wider rows are split over more workgroups along y.
+inline constexpr uint32_t occupancy_word_cells = 32;
+inline constexpr uint32_t max_occupancy_words_per_row = 32;
+inline constexpr uint32_t rows_per_task_workgroup = 32;
+// mesh.glsl, each meshlet cell is 4 vertices and 2 primitives. The 32 and 64 cell variants are compiled.
+inline constexpr uint32_t max_meshlet_cells = 64;
+// stages of each renderer's pipeline layout that see the pane push constants, the task and mesh bits
+// are only valid with the mesh shader extension.
+inline const vk::ShaderStageFlags mesh_pane_stages =
+    vk::ShaderStageFlagBits::eTaskEXT | vk::ShaderStageFlagBits::eMeshEXT | vk::ShaderStageFlagBits::eFragment;
+inline const vk::ShaderStageFlags vertex_pane_stages =
+    vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment;
+// push constants of overlay_parameters.glsl.
+struct overlay_push_constants {
+    // left, top, right, bottom in normalized device coordinates of the pane viewport.
+    std::array<float, 4> rect;
+    std::array<float, 4> color;
+};
+inline const vk::ShaderStageFlags overlay_push_constant_stages =
+    vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment;
+
+enum class cursor_shape {
+    eBlock,
+    eUnderline,
+    eBar,
+};
+struct pane_cursor {
+    uint32_t x;
+    uint32_t y;
+    cursor_shape shape;
+    // the blink phase, a hidden cursor draws nothing.
+    bool visible;
+};
+// stream selection between two cells, both included, in either order.
+struct pane_selection {
+    uint32_t start_x;
+    uint32_t start_y;
+    uint32_t end_x;
+    uint32_t end_y;
+};
+
+struct terminal_pane {
+    multidimention_vector<terminal_cell>* terminal_buffer;
+    vk::Rect2D viewport;
+    // range of the pane in the packed cells buffer.
+    uint32_t cell_offset;
+    uint32_t cell_count;
+    // row bitmasks of the pane in the occupancy buffer.
+    uint32_t occupancy_offset;
+    // if set, terminal_buffer is the render thread's copy of the latest published snapshot.
+    triple_buffered_grid<terminal_cell>* snapshots;
+    std::vector<uint64_t> row_versions;
+    // drawn by the overlay pass, independent of the cells.
+    std::optional<pane_cursor> cursor;
+    std::optional<pane_selection> selection;
+    // sub-cell scroll in cells, a push constant so every pixel step between whole lines is free.
+    std::array<float, 2> scroll_offset{};
+    // the last terminal_buffer row is only shown while scroll_offset uncovers it.
+    bool guard_row{};
+    // first scrollback line in terminal_buffer after scroll_to.
+    std::optional<size_t> scrollback_first_line{};
+};
+struct pane_draw_info {
+    vk::Rect2D viewport;
+    pane_push_constants push_constants;
+};
+
 class simple_draw_command {
 public:
     simple_draw_command(
@@ -16,12 +110,15 @@ public:
         vk::DescriptorSet descriptor_set,
         vk::Framebuffer framebuffer,
         vk::Extent2D swapchain_extent,
+        vk::ClearColorValue clear_color,
+        std::span<const pane_draw_info> panes,
+        const std::function<void(vk::CommandBuffer)>& record_overlays,
         vk::detail::DispatchLoaderDynamic dldid)
         : m_cmd{ cmd } {
-        vk::CommandBufferBeginInfo begin_info{ vk::CommandBufferUsageFlagBits::eSimultaneousUse };
+        vk::CommandBufferBeginInfo begin_info{ vk::CommandBufferUsageFlagBits::eOneTimeSubmit };
         cmd.begin(begin_info);
         std::array<vk::ClearValue, 2> clear_values;
-        clear_values[0].color = vk::ClearColorValue{ 1.0f, 1.0f,1.0f,1.0f };
+        clear_values[0].color = clear_color;
         clear_values[1].depthStencil = vk::ClearDepthStencilValue{ 1.0f, 0 };
         vk::RenderPassBeginInfo render_pass_begin_info{
             render_pass, framebuffer,
@@ -33,10 +130,16 @@ public:
         cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics,
             pipeline_layout, 0, descriptor_set, nullptr);
         //cmd.bindVertexBuffers(0, *vertex_buffer, { 0 });
-        cmd.setViewport(0, vk::Viewport(0, 0, swapchain_extent.width, swapchain_extent.height, 0, 1));
-        cmd.setScissor(0, vk::Rect2D(vk::Offset2D(0, 0), swapchain_extent));
-        //cmd.draw(3, 1, 0, 0);
-        cmd.drawMeshTasksEXT(1, 1, 1, dldid);
+        for (auto& pane : panes) {
+            cmd.setViewport(0, vk::Viewport(pane.viewport.offset.x, pane.viewport.offset.y, pane.viewport.extent.width, pane.viewport.extent.height, 0, 1));
+            cmd.setScissor(0, pane.viewport);
+            cmd.pushConstants<pane_push_constants>(pipeline_layout, mesh_pane_stages, 0, pane.push_constants);
+            //cmd.draw(3, 1, 0, 0);
+            auto words_per_row = (pane.push_constants.width + occupancy_word_cells - 1) / occupancy_word_cells;
+            cmd.drawMeshTasksEXT((pane.push_constants.height + rows_per_task_workgroup - 1) / rows_per_task_workgroup,
+                (words_per_row + max_occupancy_words_per_row - 1) / max_occupancy_words_per_row, 1, dldid);
+        }
+        record_overlays(cmd);
         cmd.endRenderPass();
         cmd.end();
     }
@@ -66,13 +169,22 @@ namespace concept_helper {
     }
 }
 
+// the surface of a chain that presents, a null surface for one that does not.
+vk::SurfaceKHR get_chain_surface(auto& chain) {
+    if constexpr (requires { chain.get_vulkan_shared_surface(); }) {
+        return *chain.get_vulkan_shared_surface();
+    }
+    else {
+        return vk::SurfaceKHR{};
+    }
+}
+
 template<concept_helper::shared::instance Instance>
 class add_shared_physical_device : public Instance {
 public:
     add_shared_physical_device() {
         auto shared_instance = Instance::get_vulkan_shared_instance();
-        auto physical_devices = shared_instance->enumeratePhysicalDevices();
-        m_physical_device = vk::SharedPhysicalDevice{ physical_devices[0], shared_instance};
+        m_physical_device = vk::SharedPhysicalDevice{ vulkan::select_physical_device(*shared_instance, get_chain_surface(*this)), shared_instance};
     }
     auto get_vulkan_physical_device() {
         return *m_physical_device;
@@ -103,61 +215,74 @@ public:
 
 class mesh_device_create_info {
 public:
-    mesh_device_create_info(uint32_t queue_family_index, std::vector<std::string> device_extensions)
-    : m_queue_priority{}, m_queue_create_info{}, m_structure_chain{}, m_device_extensions{device_extensions} {
+    // the transfer family gets a queue of its own, for upload_queue.
+    mesh_device_create_info(uint32_t queue_family_index, std::optional<uint32_t> transfer_queue_family_index,
+        std::vector<std::string> device_extensions)
+    : m_queue_priority{}, m_queue_create_infos{}, m_structure_chain{}, m_device_extensions{device_extensions} {
         m_queue_priority = 0.0f;
-        m_queue_create_info.setQueuePriorities(m_queue_priority).setQueueFamilyIndex(queue_family_index);
+        m_queue_create_infos.push_back(vk::DeviceQueueCreateInfo{}.setQueuePriorities(m_queue_priority).setQueueFamilyIndex(queue_family_index));
+        if (transfer_queue_family_index) {
+            m_queue_create_infos.push_back(vk::DeviceQueueCreateInfo{}.setQueuePriorities(m_queue_priority).setQueueFamilyIndex(*transfer_queue_family_index));
+        }
 
         m_raw_ptr_device_extensions.resize(m_device_extensions.size());
         std::ranges::transform(
             m_device_extensions,
             m_raw_ptr_device_extensions.begin(),
             [](auto& ext) { return ext.c_str();  });
-        m_structure_chain.get<vk::DeviceCreateInfo>().setQueueCreateInfos(m_queue_create_info).setPEnabledExtensionNames(m_raw_ptr_device_extensions);
+        m_structure_chain.get<vk::DeviceCreateInfo>().setQueueCreateInfos(m_queue_create_infos).setPEnabledExtensionNames(m_raw_ptr_device_extensions);
         m_structure_chain.get<vk::PhysicalDeviceMeshShaderFeaturesEXT>().setMeshShader(true).setTaskShader(true);
         m_structure_chain.get<vk::PhysicalDeviceSynchronization2Features>().setSynchronization2(true);
         m_structure_chain.get<vk::PhysicalDeviceMaintenance4Features>().setMaintenance4(true);
+        m_structure_chain.get<vk::PhysicalDeviceTimelineSemaphoreFeatures>().setTimelineSemaphore(true);
     }
     vk::DeviceCreateInfo& get_device_create_info() {
         return m_structure_chain.get<vk::DeviceCreateInfo>();
     }
 private:
     float m_queue_priority;
-    vk::DeviceQueueCreateInfo m_queue_create_info;
+    std::vector<vk::DeviceQueueCreateInfo> m_queue_create_infos;
     vk::StructureChain<
         vk::DeviceCreateInfo,
         vk::PhysicalDeviceMeshShaderFeaturesEXT,
         vk::PhysicalDeviceMaintenance4Features,
-        vk::PhysicalDeviceSynchronization2Features> m_structure_chain;
+        vk::PhysicalDeviceSynchronization2Features,
+        vk::PhysicalDeviceTimelineSemaphoreFeatures> m_structure_chain;
     std::vector<std::string> m_device_extensions;
     std::vector<const char*> m_raw_ptr_device_extensions;
 };
 class vertex_device_create_info {
 public:
-    vertex_device_create_info(uint32_t queue_family_index, std::vector<std::string> device_extensions)
-        : m_queue_priority{}, m_queue_create_info{}, m_structure_chain{}, m_device_extensions{ device_extensions } {
+    vertex_device_create_info(uint32_t queue_family_index, std::optional<uint32_t> transfer_queue_family_index,
+        std::vector<std::string> device_extensions)
+        : m_queue_priority{}, m_queue_create_infos{}, m_structure_chain{}, m_device_extensions{ device_extensions } {
         m_queue_priority = 0.0f;
-        m_queue_create_info.setQueuePriorities(m_queue_priority).setQueueFamilyIndex(queue_family_index);
+        m_queue_create_infos.push_back(vk::DeviceQueueCreateInfo{}.setQueuePriorities(m_queue_priority).setQueueFamilyIndex(queue_family_index));
+        if (transfer_queue_family_index) {
+            m_queue_create_infos.push_back(vk::DeviceQueueCreateInfo{}.setQueuePriorities(m_queue_priority).setQueueFamilyIndex(*transfer_queue_family_index));
+        }
 
         m_raw_ptr_device_extensions.resize(m_device_extensions.size());
         std::ranges::transform(
             m_device_extensions,
             m_raw_ptr_device_extensions.begin(),
             [](auto& ext) { return ext.c_str();  });
-        m_structure_chain.get<vk::DeviceCreateInfo>().setQueueCreateInfos(m_queue_create_info).setPEnabledExtensionNames(m_raw_ptr_device_extensions);
+        m_structure_chain.get<vk::DeviceCreateInfo>().setQueueCreateInfos(m_queue_create_infos).setPEnabledExtensionNames(m_raw_ptr_device_extensions);
         m_structure_chain.get<vk::PhysicalDeviceSynchronization2Features>().setSynchronization2(true);
         m_structure_chain.get<vk::PhysicalDeviceMaintenance4Features>().setMaintenance4(true);
+        m_structure_chain.get<vk::PhysicalDeviceTimelineSemaphoreFeatures>().setTimelineSemaphore(true);
     }
     vk::DeviceCreateInfo& get_device_create_info() {
         return m_structure_chain.get<vk::DeviceCreateInfo>();
     }
 private:
     float m_queue_priority;
-    vk::DeviceQueueCreateInfo m_queue_create_info;
+    std::vector<vk::DeviceQueueCreateInfo> m_queue_create_infos;
     vk::StructureChain<
         vk::DeviceCreateInfo,
         vk::PhysicalDeviceMaintenance4Features,
-        vk::PhysicalDeviceSynchronization2Features> m_structure_chain;
+        vk::PhysicalDeviceSynchronization2Features,
+        vk::PhysicalDeviceTimelineSemaphoreFeatures> m_structure_chain;
     std::vector<std::string> m_device_extensions;
     std::vector<const char*> m_raw_ptr_device_extensions;
 };
@@ -166,10 +291,15 @@ template<class T>
 class add_mesh_device_create_info_aggregate : public T{
 public:
     using parent = T;
+    // runtime_selected_presenter falls back to the vertex chain on this exception.
     auto get_device_create_info_aggregate() {
+        if (!vulkan::supports_mesh_shader(parent::get_vulkan_physical_device())) {
+            throw vulkan::mesh_shader_unsupported{};
+        }
         uint32_t queue_family_index = parent::get_queue_family_index();
+        auto transfer_queue_family_index = vulkan::select_transfer_queue_family(parent::get_vulkan_physical_device(), queue_family_index);
         std::vector<std::string> deviceExtensions = parent::get_extensions();
-        return mesh_device_create_info{queue_family_index, deviceExtensions};
+        return mesh_device_create_info{queue_family_index, transfer_queue_family_index, deviceExtensions};
     }
 };
 template<class T>
@@ -178,16 +308,24 @@ public:
     using parent = T;
     auto get_device_create_info_aggregate() {
         uint32_t queue_family_index = parent::get_queue_family_index();
+        auto transfer_queue_family_index = vulkan::select_transfer_queue_family(parent::get_vulkan_physical_device(), queue_family_index);
         std::vector<std::string> deviceExtensions = parent::get_extensions();
-        return vertex_device_create_info{ queue_family_index, deviceExtensions };
+        return vertex_device_create_info{ queue_family_index, transfer_queue_family_index, deviceExtensions };
     }
 };
+// the graphics family select_physical_device scored the device with, it presents to the chain's surface.
 template<class T>
 class set_queue_family_index : public T{
 public:
+    using parent = T;
+    set_queue_family_index() {
+        m_queue_family_index = vulkan::select_queue_family(parent::get_vulkan_physical_device(), get_chain_surface(*this));
+    }
     auto get_queue_family_index() {
-        return 0;
+        return m_queue_family_index;
     }
+private:
+    uint32_t m_queue_family_index;
 };
 
 template<concept_helper::shared::physical_device PhysicalDevice>
@@ -211,6 +349,38 @@ private:
     vk::SharedDevice m_device;
 };
 
+// like add_shared_device, but every window on the same physical device attaches to one device_context.
+template<concept_helper::shared::physical_device PhysicalDevice>
+class add_shared_device_context : public PhysicalDevice {
+public:
+    using parent = PhysicalDevice;
+    add_shared_device_context() {
+        m_device_context = device_context::get_or_create(
+            parent::get_vulkan_shared_physical_device(), parent::get_queue_family_index(),
+            [this]() {
+                auto physical_device = parent::get_vulkan_physical_device();
+                auto device_create_info_aggregate = parent::get_device_create_info_aggregate();
+                return vk::SharedDevice{ physical_device.createDevice(device_create_info_aggregate.get_device_create_info()) };
+            });
+    }
+    auto get_vulkan_device() {
+        return m_device_context->get_vulkan_device();
+    }
+    auto get_vulkan_shared_device() {
+        return m_device_context->get_vulkan_shared_device();
+    }
+    auto get_device_context() {
+        return m_device_context;
+    }
+    // the family the shared device and its transfer queue family were chosen for, which may be another
+    // window's when the context already existed.
+    auto get_queue_family_index() {
+        return m_device_context->get_queue_family_index();
+    }
+private:
+    std::shared_ptr<device_context> m_device_context;
+};
+
 template<concept_helper::shared::device Device>
 class vulkan_render_prepare : public Device {
 public:
@@ -257,7 +427,9 @@ public:
     auto create_render_pass(auto device, auto color_format, auto depth_format) {
         return vk::SharedRenderPass{ vulkan::create_render_pass(*device, color_format, depth_format), device };
     }
+    // the buffers are read by the stages before rasterization, which ones depends on pane_stages.
     auto create_descriptor_set_bindings() {
+        auto buffer_stages = pane_stages & ~vk::ShaderStageFlags{ vk::ShaderStageFlagBits::eFragment };
         return std::array{
             vk::DescriptorSetLayoutBinding{}
             .setBinding(0)
@@ -266,8 +438,23 @@ public:
             .setDescriptorCount(1),
             vk::DescriptorSetLayoutBinding{}
             .setBinding(1)
+            .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+            .setStageFlags(buffer_stages)
+            .setDescriptorCount(1),
+            vk::DescriptorSetLayoutBinding{}
+            .setBinding(2)
             .setDescriptorType(vk::DescriptorType::eUniformBuffer)
-            .setStageFlags(vk::ShaderStageFlagBits::eMeshEXT)
+            .setStageFlags(buffer_stages)
+            .setDescriptorCount(1),
+            vk::DescriptorSetLayoutBinding{}
+            .setBinding(3)
+            .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+            .setStageFlags(buffer_stages)
+            .setDescriptorCount(1),
+            vk::DescriptorSetLayoutBinding{}
+            .setBinding(4)
+            .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+            .setStageFlags(buffer_stages)
             .setDescriptorCount(1),
         };
     }
@@ -276,72 +463,270 @@ public:
             vk::DescriptorSetLayoutCreateInfo{}
             .setBindings(descriptor_set_bindings));
     }
-    auto create_pipeline_layout(auto device, auto& descriptor_set_layout) {
+    auto create_push_constant_ranges() {
+        return std::array{
+            vk::PushConstantRange{}
+            .setStageFlags(pane_stages)
+            .setOffset(0)
+            .setSize(sizeof(pane_push_constants)),
+        };
+    }
+    auto create_overlay_push_constant_ranges() {
+        return std::array{
+            vk::PushConstantRange{}
+            .setStageFlags(overlay_push_constant_stages)
+            .setOffset(0)
+            .setSize(sizeof(overlay_push_constants)),
+        };
+    }
+    auto create_overlay_pipeline(auto device, auto& render_pass, auto& overlay_pipeline_layout) {
+        vulkan::vertex_stage_info vertex_stage_info{
+            overlay_vertex_shader_path, "main",
+            {},
+            {},
+        };
+        return vk::SharedPipeline{
+            vulkan::create_pipeline(*device,
+                    vertex_stage_info,
+                    overlay_fragment_shader_path,
+                    *render_pass, *overlay_pipeline_layout, *pipeline_cache).value, device };
+    }
+    auto create_pipeline_layout(auto device, auto& descriptor_set_layout, auto push_constant_ranges) {
         return vk::SharedPipelineLayout{
-            vulkan::create_pipeline_layout(*device, *descriptor_set_layout),
+            vulkan::create_pipeline_layout(*device, *descriptor_set_layout, push_constant_ranges),
+            device };
+    }
+    // the overlay only reads push constants, its layout has no descriptor sets. Overlays are recorded after
+    // the cells, so the sets bound with the cell pipeline layout are not needed anymore.
+    auto create_overlay_pipeline_layout(auto device) {
+        return vk::SharedPipelineLayout{
+            vulkan::create_pipeline_layout(*device, create_overlay_push_constant_ranges()),
             device };
     }
     auto create_descriptor_pool(auto device, auto descriptor_pool_size) {
-        return device->createDescriptorPoolUnique(vk::DescriptorPoolCreateInfo{}.setPoolSizes(descriptor_pool_size).setMaxSets(1));
+        return device->createDescriptorPoolUnique(vk::DescriptorPoolCreateInfo{}.setPoolSizes(descriptor_pool_size).setMaxSets(frames_in_flight));
     }
     auto get_descriptor_pool_size() {
         return std::array{
-            vk::DescriptorPoolSize{}.setType(vk::DescriptorType::eCombinedImageSampler).setDescriptorCount(1),
-            vk::DescriptorPoolSize{}.setType(vk::DescriptorType::eUniformBuffer).setDescriptorCount(1),
+            vk::DescriptorPoolSize{}.setType(vk::DescriptorType::eCombinedImageSampler).setDescriptorCount(frames_in_flight),
+            vk::DescriptorPoolSize{}.setType(vk::DescriptorType::eStorageBuffer).setDescriptorCount(3 * frames_in_flight),
+            vk::DescriptorPoolSize{}.setType(vk::DescriptorType::eUniformBuffer).setDescriptorCount(frames_in_flight),
         };
     }
-    auto allocate_descriptor_set(auto device, auto& descriptor_set_layout) {
-        return std::move(
-            device->allocateDescriptorSets(
-                vk::DescriptorSetAllocateInfo{}
-                .setDescriptorPool(*descriptor_pool)
-                .setSetLayouts(*descriptor_set_layout))
-            .front()
-            );
+    auto allocate_frame_descriptor_sets(auto device, auto& descriptor_set_layout) {
+        auto layouts = std::vector<vk::DescriptorSetLayout>(frames_in_flight, *descriptor_set_layout);
+        auto descriptor_sets = device->allocateDescriptorSets(
+            vk::DescriptorSetAllocateInfo{}
+            .setDescriptorPool(*descriptor_pool)
+            .setSetLayouts(layouts));
+        std::vector<frame_descriptor_set> frame_sets;
+        for (auto descriptor_set : descriptor_sets) {
+            frame_sets.emplace_back(frame_descriptor_set{ descriptor_set, 0, nullptr });
+        }
+        return frame_sets;
+    }
+    // the set and the buffers of a frame in flight are only written after the frame that used them last finished.
+    // The set is rewritten when it lags behind the current resources, steady frames write no descriptors.
+    vk::DescriptorSet get_frame_descriptor_set(uint32_t frame_index) {
+        update_frame_buffers(frame_index);
+        auto& frame_set = frame_descriptor_sets[frame_index];
+        auto& buffers = frame_buffers[frame_index];
+        if (frame_set.generation != resource_generation) {
+            update_descriptor_set(frame_set.descriptor_set, atlas->texture_view, atlas->is_sdf ? sdf_sampler : sampler,
+                buffers.packed_cells_buffer, buffers.palette_buffer, buffers.occupancy_buffer, atlas->glyph_rects_buffer);
+            frame_set.resources = std::make_shared<std::tuple<
+                std::shared_ptr<glyph_atlas>,
+                vk::SharedBuffer, std::shared_ptr<vulkan::memory_pool::allocation>,
+                vk::SharedBuffer, std::shared_ptr<vulkan::memory_pool::allocation>>>(
+                    atlas, buffers.packed_cells_buffer, buffers.packed_cells_allocation,
+                    buffers.occupancy_buffer, buffers.occupancy_allocation);
+            frame_set.generation = resource_generation;
+        }
+        return frame_set.descriptor_set;
+    }
+    // every frame in flight has its own cell and occupancy buffers, the cpu copies are written first
+    // and each frame catches up on the ranges it missed once its slot is free.
+    static void add_dirty_range(std::vector<std::pair<uint32_t, uint32_t>>& ranges, uint32_t first, uint32_t count) {
+        if (!ranges.empty() && ranges.back().first + ranges.back().second == first) {
+            ranges.back().second += count;
+            return;
+        }
+        ranges.emplace_back(first, count);
+    }
+    void mark_cells_dirty(uint32_t first, uint32_t count) {
+        for (auto& buffers : frame_buffers) {
+            add_dirty_range(buffers.dirty_cells, first, count);
+        }
+    }
+    void mark_occupancy_dirty(uint32_t first, uint32_t count) {
+        for (auto& buffers : frame_buffers) {
+            add_dirty_range(buffers.dirty_occupancy, first, count);
+        }
+    }
+    void update_frame_buffers(uint32_t frame_index) {
+        auto& buffers = frame_buffers[frame_index];
+        auto* mapped_packed_cells = static_cast<packed_cell*>(buffers.packed_cells_allocation->mapped);
+        for (auto [first, count] : buffers.dirty_cells) {
+            std::copy_n(packed_cells.data() + first, count, mapped_packed_cells + first);
+        }
+        buffers.dirty_cells.clear();
+        auto* mapped_occupancy = static_cast<uint32_t*>(buffers.occupancy_allocation->mapped);
+        for (auto [first, count] : buffers.dirty_occupancy) {
+            std::copy_n(occupancy.data() + first, count, mapped_occupancy + first);
+        }
+        buffers.dirty_occupancy.clear();
+        if (buffers.palette_dirty) {
+            vulkan::copy_to_mapped_memory(static_cast<color_palette::value_type*>(buffers.palette_allocation->mapped), palette);
+            buffers.palette_dirty = false;
+        }
+    }
+    // fresh buffers are not read by any frame yet, they are filled right away.
+    void create_frame_buffers() {
+        for (auto& buffers : frame_buffers) {
+            std::tie(buffers.packed_cells_buffer, buffers.packed_cells_allocation) =
+                create_pooled_buffer(std::max<size_t>(packed_cells.size(), 1) * sizeof(packed_cell), vk::BufferUsageFlagBits::eStorageBuffer);
+            vulkan::copy_to_mapped_memory(static_cast<packed_cell*>(buffers.packed_cells_allocation->mapped), packed_cells);
+            std::tie(buffers.occupancy_buffer, buffers.occupancy_allocation) =
+                create_pooled_buffer(std::max<size_t>(occupancy.size(), 1) * sizeof(uint32_t), vk::BufferUsageFlagBits::eStorageBuffer);
+            vulkan::copy_to_mapped_memory(static_cast<uint32_t*>(buffers.occupancy_allocation->mapped), occupancy);
+            buffers.dirty_cells.clear();
+            buffers.dirty_occupancy.clear();
+        }
     }
 
-    auto create_font_texture(auto characters) {
+    // with sdf the glyphs are rasterized once at the reference size and stored as distance fields,
+    // fragment.glsl then reconstructs sharp coverage at any on screen cell size.
+    // the glyphs are rasterized into a staging buffer and copied into a device local texture by the upload queue,
+    // the returned upload value is what the graphics queue waits on when it acquires the texture.
+    // glyph bitmaps are skyline packed by their own size into layers of at most glyph_atlas_page_size,
+    // further layers are added instead of growing past the device's maxImageDimension2D.
+    auto create_font_texture(auto characters, bool sdf) {
         auto physical_device = parent::get_vulkan_physical_device();
         auto device = parent::get_vulkan_device();
         auto shared_device = parent::get_vulkan_shared_device();
-        font_loader font_loader{};
-        uint32_t font_width = 32, font_height = 32;
-        uint32_t line_height = font_height * 2;
-        font_loader.set_char_size(font_width, font_height);
-        auto [vk_texture, vk_texture_memory, vk_texture_view] =
-            vulkan::create_texture(physical_device, device,
-                vk::Format::eR8Unorm,
-                font_width * std::size(characters), line_height,
-                [&font_loader, font_width, font_height, line_height, &characters](char* ptr, int pitch) {
-                    std::ranges::for_each(from_0_count_n(characters.size()),
-                    [&font_loader, font_width, font_height, line_height, &characters, ptr, pitch](auto i) {
-                            font_loader.render_char(characters[i]);
-                            auto glyph = font_loader.get_glyph();
-                            uint32_t start_row = font_height - glyph->bitmap_top - 1;
-                            assert(start_row + glyph->bitmap.rows < line_height);
-                            for (int row = 0; row < glyph->bitmap.rows; row++) {
-                                for (int x = 0; x < glyph->bitmap.width; x++) {
-                                    ptr[(start_row + row) * pitch + glyph->bitmap_left + i * font_width + x] =
-                                        glyph->bitmap.buffer[row * glyph->bitmap.pitch + x];
-                                }
-                            }
-                        });
-                });
+        glyph_tile_metrics metrics{};
+        auto limits = physical_device.getProperties().limits;
+        // a blank border keeps filtering from reaching into the neighbours, distance fields need room to fall off.
+        auto padding = sdf ? static_cast<uint32_t>(std::ceil(sdf_spread)) + 1 : 1u;
+        auto bitmaps = render_glyph_bitmaps(fonts, characters, metrics, padding, sdf, sdf_spread);
+        auto packing = pack_glyph_bitmaps(bitmaps,
+            std::min(glyph_atlas_page_size, limits.maxImageDimension2D), limits.maxImageArrayLayers);
+        auto extent = vk::Extent2D{ packing.width, packing.height };
+        auto format = vk::Format::eR8Unorm;
         auto texture = vk::SharedImage{
-            vk_texture, shared_device };
+            vulkan::create_array_image(device, format, extent, packing.layers, vk::ImageTiling::eOptimal,
+                vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst),
+            shared_device };
+        auto [vk_texture_memory, texture_memory_size] =
+            vulkan::allocate_device_memory(physical_device, device, *texture, vk::MemoryPropertyFlagBits::eDeviceLocal);
         auto texture_memory = vk::SharedDeviceMemory{ vk_texture_memory, shared_device };
-        auto texture_view = vk::SharedImageView{ vk_texture_view, shared_device };
-        return std::tuple{ texture, texture_memory, texture_view };
+        device.bindImageMemory(*texture, *texture_memory, 0);
+        auto texture_view = vk::SharedImageView{
+            vulkan::create_array_image_view(device, *texture, format, vk::ImageAspectFlagBits::eColor, packing.layers),
+            shared_device };
+
+        auto staging_size = packing.get_byte_size();
+        auto [staging_buffer, staging_allocation] = create_pooled_buffer(std::max<size_t>(staging_size, 1), vk::BufferUsageFlagBits::eTransferSrc);
+        auto staging = static_cast<unsigned char*>(staging_allocation->mapped);
+        std::fill_n(staging, staging_size, 0);
+        write_packed_glyphs(bitmaps, packing, staging);
+        auto upload_value = uploads->submit(
+            [texture = *texture, buffer = *staging_buffer, extent, layers = packing.layers, uploads = uploads](vk::CommandBuffer cmd) {
+                vulkan::record_texture_upload(cmd, texture, buffer, extent, layers,
+                    uploads->get_queue_family_index(), uploads->get_graphics_queue_family_index());
+            },
+            std::make_shared<std::tuple<vk::SharedBuffer, std::shared_ptr<vulkan::memory_pool::allocation>, vk::SharedImage, vk::SharedDeviceMemory>>(
+                staging_buffer, staging_allocation, texture, texture_memory));
+        auto glyph_rects = generate_glyph_rects(bitmaps, packing, metrics);
+        auto [glyph_rects_buffer, glyph_rects_allocation] =
+            create_pooled_buffer(std::max<size_t>(glyph_rects.size(), 1) * sizeof(glyph_rect), vk::BufferUsageFlagBits::eStorageBuffer);
+        vulkan::copy_to_mapped_memory(static_cast<glyph_rect*>(glyph_rects_allocation->mapped), glyph_rects);
+        return std::tuple{ texture, texture_memory, texture_view, packing.layers, glyph_rects_buffer, glyph_rects_allocation, upload_value };
+    }
+    auto generate_glyph_rects(const std::vector<glyph_bitmap>& bitmaps, const glyph_packing& packing, glyph_tile_metrics metrics) {
+        std::vector<glyph_rect> glyph_rects(bitmaps.size());
+        for (size_t i = 0; i < bitmaps.size(); i++) {
+            auto& bitmap = bitmaps[i];
+            auto& place = packing.placements[i];
+            glyph_rects[i] = glyph_rect{
+                {
+                    static_cast<float>(place.x) / packing.width, static_cast<float>(place.y) / packing.height,
+                    static_cast<float>(bitmap.width) / packing.width, static_cast<float>(bitmap.height) / packing.height },
+                {
+                    static_cast<float>(bitmap.left) / metrics.font_width, static_cast<float>(bitmap.top) / metrics.line_height,
+                    static_cast<float>(bitmap.width) / metrics.font_width, static_cast<float>(bitmap.height) / metrics.line_height },
+                place.layer, {} };
+        }
+        return glyph_rects;
+    }
+    auto create_glyph_atlas(auto& char_set) {
+        auto characters = generate_characters(char_set);
+        auto [texture, texture_memory, texture_view, layers, glyph_rects_buffer, glyph_rects_allocation, upload_value] =
+            create_font_texture(characters, sdf_atlas);
+        auto char_texture_indices = generate_char_texture_indices(characters);
+        return std::make_shared<glyph_atlas>(
+            texture, texture_memory, texture_view, layers, glyph_rects_buffer, glyph_rects_allocation,
+            characters, char_texture_indices, sdf_atlas, upload_value, false);
     }
-    void update_descriptor_set(auto descriptor_set, auto texture_view, auto& sampler, auto& char_indices_buffer) {
+    // the atlas is only rebuilt when a glyph is missing, it then keeps the glyphs it already had while they fit.
+    auto acquire_glyph_atlas(auto& char_set) {
+        auto current_atlas = atlas;
+        if constexpr (requires { parent::get_device_context(); }) {
+            current_atlas = parent::get_device_context()->get_glyph_atlas();
+        }
+        if (current_atlas && current_atlas->is_sdf != sdf_atlas) {
+            current_atlas = nullptr;
+        }
+        if (current_atlas && current_atlas->contains(char_set)) {
+            return current_atlas;
+        }
+        auto atlas_char_set = char_set;
+        if (current_atlas) {
+            atlas_char_set.insert(current_atlas->characters.begin(), current_atlas->characters.end());
+            if (atlas_char_set.size() > glyph_atlas::max_kept_glyph_count) {
+                atlas_char_set = char_set;
+            }
+        }
+        auto new_atlas = create_glyph_atlas(atlas_char_set);
+        if constexpr (requires { parent::get_device_context(); }) {
+            parent::get_device_context()->set_glyph_atlas(new_atlas);
+        }
+        return new_atlas;
+    }
+    // buffer memory comes from the memory pool, which is shared with other windows of a device_context.
+    auto create_pooled_buffer(vk::DeviceSize size, vk::BufferUsageFlags usages) {
+        auto device = parent::get_vulkan_device();
+        auto buffer = vk::SharedBuffer{ vulkan::create_buffer(device, size, usages), parent::get_vulkan_shared_device() };
+        auto allocation = memory_pool->allocate(device.getBufferMemoryRequirements(*buffer),
+            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+        device.bindBufferMemory(*buffer, allocation->memory, allocation->offset);
+        return std::tuple{ buffer, allocation };
+    }
+    void update_descriptor_set(auto descriptor_set, auto texture_view, auto& sampler, auto& packed_cells_buffer, auto& palette_buffer,
+        auto& occupancy_buffer, auto& glyph_rects_buffer) {
         auto texture_image_info =
             vk::DescriptorImageInfo{}
             .setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
             .setImageView(*texture_view)
             .setSampler(*sampler);
-        auto char_texture_indices_info =
+        auto packed_cells_info =
+            vk::DescriptorBufferInfo{}
+            .setBuffer(*packed_cells_buffer)
+            .setOffset(0)
+            .setRange(vk::WholeSize);
+        auto palette_info =
+            vk::DescriptorBufferInfo{}
+            .setBuffer(*palette_buffer)
+            .setOffset(0)
+            .setRange(vk::WholeSize);
+        auto occupancy_info =
+            vk::DescriptorBufferInfo{}
+            .setBuffer(*occupancy_buffer)
+            .setOffset(0)
+            .setRange(vk::WholeSize);
+        auto glyph_rects_info =
             vk::DescriptorBufferInfo{}
-            .setBuffer(*char_indices_buffer)
+            .setBuffer(*glyph_rects_buffer)
             .setOffset(0)
             .setRange(vk::WholeSize);
         auto descriptor_set_write = std::array{
@@ -352,88 +737,455 @@ public:
             .setDstSet(descriptor_set),
             vk::WriteDescriptorSet{}
             .setDstBinding(1)
+            .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+            .setBufferInfo(packed_cells_info)
+            .setDstSet(descriptor_set),
+            vk::WriteDescriptorSet{}
+            .setDstBinding(2)
             .setDescriptorType(vk::DescriptorType::eUniformBuffer)
-            .setBufferInfo(char_texture_indices_info)
+            .setBufferInfo(palette_info)
+            .setDstSet(descriptor_set),
+            vk::WriteDescriptorSet{}
+            .setDstBinding(3)
+            .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+            .setBufferInfo(occupancy_info)
+            .setDstSet(descriptor_set),
+            vk::WriteDescriptorSet{}
+            .setDstBinding(4)
+            .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+            .setBufferInfo(glyph_rects_info)
             .setDstSet(descriptor_set),
         };
         parent::get_vulkan_device().updateDescriptorSets(descriptor_set_write, nullptr);
     }
-    auto generate_char_set(auto& terminal_buffer) {
-        std::set<char> char_set{};
-        std::for_each(
-            terminal_buffer.begin(),
-            terminal_buffer.end(),
-            [&char_set](auto c) {
-                char_set.emplace(c);
+    auto generate_char_set(auto& panes) {
+        std::set<uint32_t> char_set{};
+        std::ranges::for_each(panes, [&char_set](auto& pane) {
+            for (size_t y = 0; y < pane.terminal_buffer->get_height(); y++) {
+                for (auto& cell : pane.terminal_buffer->get_row(y)) {
+                    char_set.emplace(cell.character);
+                }
+            }
             });
         return char_set;
     }
     auto generate_characters(auto& char_set) {
-        std::vector<char> characters{};
+        std::vector<uint32_t> characters{};
         std::ranges::copy(char_set, std::back_inserter(characters));
         return characters;
     }
     auto generate_char_texture_indices(auto& characters) {
-        std::map<char, int> char_texture_indices;
+        std::map<uint32_t, int> char_texture_indices;
         std::ranges::for_each(from_0_count_n(characters.size()), [&characters, &char_texture_indices](auto i) {
             char_texture_indices.emplace(characters[i], static_cast<int>(i));
             });
         return char_texture_indices;
     }
-    auto generate_char_indices_buf(auto& terminal_buffer, auto& char_texture_indices) {
-        multidimention_vector<uint32_t> char_indices_buf{terminal_buffer.get_width(), terminal_buffer.get_height()};
-        std::transform(
-            terminal_buffer.begin(),
-            terminal_buffer.end(),
-            char_indices_buf.begin(),
-            [&char_texture_indices](auto c) {
-                return char_texture_indices[c];
-            });
-        return char_indices_buf;
+    void pack_pane_cells(auto& pane, auto& char_texture_indices, packed_cell* packed_cells_buf) {
+        auto& terminal_buffer = *pane.terminal_buffer;
+        for (size_t y = 0; y < terminal_buffer.get_height(); y++) {
+            std::ranges::transform(
+                terminal_buffer.get_row(y),
+                packed_cells_buf + pane.cell_offset + y * terminal_buffer.get_width(),
+                [&char_texture_indices](auto& cell) {
+                    return pack_cell(cell, char_texture_indices[cell.character]);
+                });
+        }
+    }
+    // a blank cell only shows its background, it is culled when that is the clear color.
+    bool is_cell_visible(const terminal_cell& cell) {
+        if ((cell.character != ' ' && cell.character != '\0') || (cell.style & (eUnderline | eStrikethrough))) {
+            return true;
+        }
+        auto background = resolve_color((cell.style & eInverse) ? cell.foreground : cell.background, palette);
+        return background != std::array<float, 4>{
+            clear_color.float32[0], clear_color.float32[1], clear_color.float32[2], clear_color.float32[3] };
+    }
+    static uint32_t get_occupancy_words_per_row(const terminal_pane& pane) {
+        return static_cast<uint32_t>((pane.terminal_buffer->get_width() + occupancy_word_cells - 1) / occupancy_word_cells);
+    }
+    void generate_row_occupancy(const terminal_pane& pane, size_t y, uint32_t* occupancy_buf) {
+        auto words_per_row = get_occupancy_words_per_row(pane);
+        auto* words = occupancy_buf + pane.occupancy_offset + y * words_per_row;
+        std::fill_n(words, words_per_row, 0);
+        auto row = pane.terminal_buffer->get_row(y);
+        for (size_t x = 0; x < row.size(); x++) {
+            if (is_cell_visible(row[x])) {
+                words[x / occupancy_word_cells] |= 1u << (x % occupancy_word_cells);
+            }
+        }
+    }
+    // the task shader launches mesh work only for the non zero words of this bitmask.
+    auto generate_occupancy(auto& panes) {
+        uint32_t word_count = 0;
+        for (auto& pane : panes) {
+            pane.occupancy_offset = word_count;
+            word_count += get_occupancy_words_per_row(pane) * pane.terminal_buffer->get_height();
+        }
+        std::vector<uint32_t> occupancy_buf(word_count);
+        for (auto& pane : panes) {
+            for (size_t y = 0; y < pane.terminal_buffer->get_height(); y++) {
+                generate_row_occupancy(pane, y, occupancy_buf.data());
+            }
+        }
+        return occupancy_buf;
+    }
+    void update_row_occupancy(const terminal_pane& pane, size_t y) {
+        generate_row_occupancy(pane, y, occupancy.data());
+        auto words_per_row = get_occupancy_words_per_row(pane);
+        mark_occupancy_dirty(static_cast<uint32_t>(pane.occupancy_offset + y * words_per_row), words_per_row);
+    }
+    // palette and clear color decide which blank cells are visible.
+    void refresh_occupancy() {
+        if (!frame_buffers.front().occupancy_buffer) {
+            return;
+        }
+        occupancy = generate_occupancy(panes);
+        for (auto& buffers : frame_buffers) {
+            buffers.dirty_occupancy.assign(1, { 0u, static_cast<uint32_t>(occupancy.size()) });
+        }
+    }
+    // panes are laid out one after another, each pane gets its range in the packed cells buffer.
+    auto generate_packed_cells(auto& panes, auto& char_texture_indices) {
+        uint32_t cell_count = 0;
+        for (auto& pane : panes) {
+            pane.cell_offset = cell_count;
+            pane.cell_count = pane.terminal_buffer->size();
+            cell_count += pane.cell_count;
+        }
+        std::vector<packed_cell> packed_cells_buf(cell_count);
+        for (auto& pane : panes) {
+            pack_pane_cells(pane, char_texture_indices, packed_cells_buf.data());
+        }
+        return packed_cells_buf;
     }
     void create_and_update_terminal_buffer_relate_data(
-        auto descriptor_set, auto& sampler, auto& terminal_buffer,
+        auto& sampler, auto& panes,
         auto& imageViews) {
         auto physical_device = parent::get_vulkan_physical_device();
         auto device = parent::get_vulkan_device();
         auto shared_device = parent::get_vulkan_shared_device();
         //generated by attribute_dependence_parser from vulkan_render_prepare_create_and_update_terminal_buffer_relate_data.depend
-        auto char_set = generate_char_set(terminal_buffer);
+        auto char_set = generate_char_set(panes);
 
 
-        character_count = char_set.size();
+        atlas = acquire_glyph_atlas(char_set);
 
 
-        auto characters = generate_characters(char_set);
-
-
-        std::tie(texture, texture_memory, texture_view) = create_font_texture(characters);
-
-
-        auto char_texture_indices = generate_char_texture_indices(characters);
+        packed_cells = generate_packed_cells(panes, atlas->char_texture_indices);
 
 
-        char_indices = generate_char_indices_buf(terminal_buffer, char_texture_indices);
+        occupancy = generate_occupancy(panes);
 
 
-        char_indices_buffer = vk::SharedBuffer(vulkan::create_buffer(device, char_indices.size() * sizeof(*std::begin(char_indices)),
-            vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eVertexBuffer), shared_device);
+        // pool memory stays mapped, so a single cell can be rewritten without another upload.
+        create_frame_buffers();
 
 
-        char_indices_buffer_memory = vk::SharedDeviceMemory(
-            std::get<0>(
-                vulkan::allocate_device_memory(physical_device, device, *char_indices_buffer,
-                    vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent)),
-            shared_device);
-
-
-        vulkan::copy_to_buffer(device, *char_indices_buffer, *char_indices_buffer_memory, char_indices);
-
-
-        device.bindBufferMemory(*char_indices_buffer, *char_indices_buffer_memory, 0);
-
-
-        update_descriptor_set(descriptor_set, texture_view, sampler, char_indices_buffer);
+        // the frame descriptor sets pick the new resources up when their frames are recorded.
+        resource_generation++;
+    }
+    // repacks only the range of one pane, false if the pane needs a glyph or a size the current atlas and buffer do not have.
+    bool update_pane_cells(size_t pane_index) {
+        auto& pane = panes[pane_index];
+        if (pane.terminal_buffer->size() != pane.cell_count) {
+            return false;
+        }
+        for (size_t y = 0; y < pane.terminal_buffer->get_height(); y++) {
+            for (auto& cell : pane.terminal_buffer->get_row(y)) {
+                if (!atlas->char_texture_indices.contains(cell.character)) {
+                    return false;
+                }
+            }
+        }
+        pack_pane_cells(pane, atlas->char_texture_indices, packed_cells.data());
+        mark_cells_dirty(pane.cell_offset, pane.cell_count);
+        for (size_t y = 0; y < pane.terminal_buffer->get_height(); y++) {
+            update_row_occupancy(pane, y);
+        }
+        return true;
+    }
+    bool update_pane_row(terminal_pane& pane, size_t y) {
+        auto row = pane.terminal_buffer->get_row(y);
+        for (auto& cell : row) {
+            if (!atlas->char_texture_indices.contains(cell.character)) {
+                return false;
+            }
+        }
+        auto first = pane.cell_offset + pane.terminal_buffer->get_linear_index(std::pair{ size_t{ 0 }, y });
+        std::ranges::transform(row, packed_cells.data() + first, [this](auto& cell) {
+            return pack_cell(cell, atlas->char_texture_indices[cell.character]);
+            });
+        mark_cells_dirty(static_cast<uint32_t>(first), static_cast<uint32_t>(row.size()));
+        update_row_occupancy(pane, y);
+        return true;
+    }
+    // the parser thread writes cells through this queue, only the render thread touches the pane grids then.
+    auto& get_update_queue() {
+        return update_queue;
+    }
+    // full uploads of the glyph atlas and cell buffers so far, init included.
+    uint64_t get_upload_count() const {
+        return resource_generation;
+    }
+    // the writer thread edits and publishes the grid, the pane follows its latest snapshot from drain_updates.
+    void attach_pane_snapshots(size_t pane_index, triple_buffered_grid<terminal_cell>& snapshots) {
+        panes[pane_index].snapshots = &snapshots;
+        panes[pane_index].row_versions.clear();
+    }
+    // copies only the rows whose version changed since the last synced snapshot.
+    void sync_pane_snapshot(terminal_pane& pane, std::vector<bool>& dirty_rows) {
+        if (pane.snapshots == nullptr) {
+            return;
+        }
+        auto& snapshot = pane.snapshots->read();
+        auto& terminal_buffer = *pane.terminal_buffer;
+        if (snapshot.width != terminal_buffer.get_width() || snapshot.height != terminal_buffer.get_height()) {
+            terminal_buffer = multidimention_vector<terminal_cell>(snapshot.width, snapshot.height);
+            pane.row_versions.clear();
+        }
+        pane.row_versions.resize(snapshot.height, UINT64_MAX);
+        dirty_rows.resize(snapshot.height);
+        for (size_t y = 0; y < snapshot.height; y++) {
+            if (pane.row_versions[y] != snapshot.rows[y]->version) {
+                snapshot.copy_row_to(y, terminal_buffer);
+                pane.row_versions[y] = snapshot.rows[y]->version;
+                dirty_rows[y] = true;
+            }
+        }
+    }
+    // applies every published cell_update to the pane grids and repacks each touched row once,
+    // false if a pane needs a glyph or a size the current atlas and buffer do not have.
+    bool drain_updates() {
+        std::vector<std::vector<bool>> dirty_rows(panes.size());
+        for (size_t pane_index = 0; pane_index < panes.size(); pane_index++) {
+            sync_pane_snapshot(panes[pane_index], dirty_rows[pane_index]);
+        }
+        update_queue.pop_all([this, &dirty_rows](const cell_update& update) {
+            if (update.pane >= panes.size()) {
+                return;
+            }
+            auto& terminal_buffer = *panes[update.pane].terminal_buffer;
+            if (update.y >= terminal_buffer.get_height() || update.x >= terminal_buffer.get_width()) {
+                return;
+            }
+            auto count = std::min<size_t>(update.count, terminal_buffer.get_width() - update.x);
+            std::ranges::fill(terminal_buffer.get_row(update.y).subspan(update.x, count), update.cell);
+            auto& rows = dirty_rows[update.pane];
+            rows.resize(terminal_buffer.get_height());
+            rows[update.y] = true;
+            });
+        bool up_to_date = true;
+        for (size_t pane_index = 0; pane_index < panes.size(); pane_index++) {
+            auto& pane = panes[pane_index];
+            auto& rows = dirty_rows[pane_index];
+            if (rows.empty()) {
+                continue;
+            }
+            if (!update_pane_rows(pane_index, rows)) {
+                up_to_date = false;
+            }
+        }
+        return up_to_date;
+    }
+    // repacks the rows marked in dirty_rows, false like update_pane_cells.
+    bool update_pane_rows(size_t pane_index, const std::vector<bool>& dirty_rows) {
+        auto& pane = panes[pane_index];
+        if (pane.terminal_buffer->size() != pane.cell_count) {
+            return false;
+        }
+        bool up_to_date = true;
+        for (size_t y = 0; y < std::min(dirty_rows.size(), pane.terminal_buffer->get_height()); y++) {
+            if (dirty_rows[y] && !update_pane_row(pane, y)) {
+                up_to_date = false;
+            }
+        }
+        return up_to_date;
+    }
+    void set_cell_attributes(size_t pane_index, size_t x, size_t y, cell_color foreground, cell_color background, uint32_t style) {
+        auto& pane = panes[pane_index];
+        auto& cell = (*pane.terminal_buffer)[std::pair{ x, y }];
+        cell.foreground = foreground;
+        cell.background = background;
+        cell.style = style;
+        auto index = pane.cell_offset + pane.terminal_buffer->get_linear_index(std::pair{ x, y });
+        packed_cells[index] = pack_cell(cell, packed_cells[index].get_glyph_index());
+        mark_cells_dirty(static_cast<uint32_t>(index), 1);
+        update_row_occupancy(pane, y);
+    }
+    void set_cell_attributes(size_t x, size_t y, cell_color foreground, cell_color background, uint32_t style) {
+        set_cell_attributes(0, x, y, foreground, background, style);
+    }
+    // the pane is drawn after the next notify_update.
+    size_t add_pane(multidimention_vector<terminal_cell>& terminal_buffer, vk::Rect2D viewport) {
+        panes.emplace_back(terminal_pane{ &terminal_buffer, viewport, 0, 0, 0, nullptr, {} });
+        return panes.size() - 1;
+    }
+    // shows scrollback lines first_line.. in the pane, false like update_pane_cells.
+    bool show_scrollback(size_t pane_index, const scrollback_store& scrollback, size_t first_line) {
+        scrollback.map_window(first_line, panes[pane_index].terminal_buffer->get_view(), terminal_cell{ ' ' });
+        panes[pane_index].scrollback_first_line = first_line;
+        return update_pane_cells(pane_index);
+    }
+    // switches between coverage and signed distance field glyphs, takes effect with the next notify_update.
+    void set_sdf_atlas(bool enable) {
+        sdf_atlas = enable;
+    }
+    // the overlay setters take effect with the next recorded frame, a blink or a drag only changes push constants.
+    void set_cursor(size_t pane_index, std::optional<pane_cursor> cursor) {
+        panes[pane_index].cursor = cursor;
+    }
+    void set_cursor_visible(size_t pane_index, bool visible) {
+        if (auto& cursor = panes[pane_index].cursor) {
+            cursor->visible = visible;
+        }
+    }
+    void set_selection(size_t pane_index, std::optional<pane_selection> selection) {
+        panes[pane_index].selection = selection;
+    }
+    // straight alpha, blended over the cells.
+    void set_overlay_colors(std::array<float, 4> new_cursor_color, std::array<float, 4> new_selection_color) {
+        cursor_color = new_cursor_color;
+        selection_color = new_selection_color;
+    }
+    // selection rectangles first, then the cursor, in cell units of the pane, scrolled with the cells and clamped to the pane.
+    std::vector<std::pair<vk::Rect2D, overlay_push_constants>> get_overlay_draws() {
+        std::vector<std::pair<vk::Rect2D, overlay_push_constants>> draws;
+        for (auto& pane : panes) {
+            auto width = static_cast<float>(pane.terminal_buffer->get_width());
+            auto height = static_cast<float>(get_visible_height(pane));
+            if (width == 0 || height == 0) {
+                continue;
+            }
+            auto add_rect = [&draws, &pane, width, height](float left, float top, float right, float bottom, std::array<float, 4> color) {
+                auto [scroll_x, scroll_y] = pane.scroll_offset;
+                left -= scroll_x;
+                right -= scroll_x;
+                top -= scroll_y;
+                bottom -= scroll_y;
+                left = std::clamp(left, 0.0f, width);
+                right = std::clamp(right, 0.0f, width);
+                top = std::clamp(top, 0.0f, height);
+                bottom = std::clamp(bottom, 0.0f, height);
+                if (left >= right || top >= bottom) {
+                    return;
+                }
+                draws.emplace_back(pane.viewport, overlay_push_constants{
+                    { left / width * 2 - 1, top / height * 2 - 1, right / width * 2 - 1, bottom / height * 2 - 1 }, color });
+            };
+            if (auto& selection = pane.selection) {
+                auto start = std::pair{ selection->start_y, selection->start_x };
+                auto end = std::pair{ selection->end_y, selection->end_x };
+                if (end < start) {
+                    std::swap(start, end);
+                }
+                auto [start_y, start_x] = start;
+                auto [end_y, end_x] = end;
+                if (start_y == end_y) {
+                    add_rect(start_x, start_y, end_x + 1.0f, start_y + 1.0f, selection_color);
+                }
+                else {
+                    add_rect(start_x, start_y, width, start_y + 1.0f, selection_color);
+                    add_rect(0, start_y + 1.0f, width, static_cast<float>(end_y), selection_color);
+                    add_rect(0, end_y, end_x + 1.0f, end_y + 1.0f, selection_color);
+                }
+            }
+            if (auto& cursor = pane.cursor; cursor && cursor->visible) {
+                float x = cursor->x;
+                float y = cursor->y;
+                switch (cursor->shape) {
+                case cursor_shape::eBlock:
+                    add_rect(x, y, x + 1, y + 1, cursor_color);
+                    break;
+                case cursor_shape::eUnderline:
+                    add_rect(x, y + 0.875f, x + 1, y + 1, cursor_color);
+                    break;
+                case cursor_shape::eBar:
+                    add_rect(x, y, x + 0.125f, y + 1, cursor_color);
+                    break;
+                }
+            }
+        }
+        return draws;
+    }
+    // recorded inside the render pass after the cells, nothing is bound when there is no overlay.
+    void record_overlays(vk::CommandBuffer cmd) {
+        auto draws = get_overlay_draws();
+        if (draws.empty()) {
+            return;
+        }
+        cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *overlay_pipeline);
+        for (auto& [viewport, push_constants] : draws) {
+            cmd.setViewport(0, vk::Viewport(viewport.offset.x, viewport.offset.y, viewport.extent.width, viewport.extent.height, 0, 1));
+            cmd.setScissor(0, viewport);
+            cmd.pushConstants<overlay_push_constants>(*overlay_pipeline_layout, overlay_push_constant_stages, 0, push_constants);
+            cmd.draw(6, 1, 0, 0);
+        }
+    }
+    // takes effect with the next recorded frame.
+    void set_pane_viewport(size_t pane_index, vk::Rect2D viewport) {
+        panes[pane_index].viewport = viewport;
+    }
+    // with a guard row the pane's terminal_buffer holds one row more than the viewport shows.
+    void set_pane_guard_row(size_t pane_index, bool enable) {
+        panes[pane_index].guard_row = enable;
+    }
+    // shifts the pane's grid up and left by a fraction of a cell, takes effect with the next recorded frame.
+    void set_pane_scroll_offset(size_t pane_index, float x, float y) {
+        panes[pane_index].scroll_offset = { x, y };
+    }
+    // scrolls the pane to a fractional scrollback line. The window is only remapped when the whole line changes,
+    // every step in between is a push constant. Needs the guard row, false like update_pane_cells.
+    bool scroll_to(size_t pane_index, const scrollback_store& scrollback, double line) {
+        auto& pane = panes[pane_index];
+        assert(pane.guard_row);
+        line = std::max(line, 0.0);
+        auto first_line = static_cast<size_t>(line);
+        pane.scroll_offset[1] = static_cast<float>(line - static_cast<double>(first_line));
+        if (pane.scrollback_first_line == first_line) {
+            return true;
+        }
+        return show_scrollback(pane_index, scrollback, first_line);
+    }
+    static size_t get_visible_height(const terminal_pane& pane) {
+        auto height = pane.terminal_buffer->get_height();
+        return pane.guard_row && height > 1 ? height - 1 : height;
+    }
+    auto get_pane_draw_infos() {
+        std::vector<pane_draw_info> draw_infos(panes.size());
+        std::ranges::transform(panes, draw_infos.begin(), [](auto& pane) {
+            return pane_draw_info{
+                pane.viewport,
+                pane_push_constants{
+                    pane.cell_offset,
+                    static_cast<uint32_t>(pane.terminal_buffer->get_width()),
+                    static_cast<uint32_t>(pane.terminal_buffer->get_height()),
+                    pane.occupancy_offset,
+                    pane.scroll_offset,
+                    static_cast<uint32_t>(get_visible_height(pane)) } };
+            });
+        return draw_infos;
+    }
+    void create_palette_buffer() {
+        for (auto& buffers : frame_buffers) {
+            std::tie(buffers.palette_buffer, buffers.palette_allocation) =
+                create_pooled_buffer(sizeof(palette), vk::BufferUsageFlagBits::eUniformBuffer);
+            vulkan::copy_to_mapped_memory(static_cast<color_palette::value_type*>(buffers.palette_allocation->mapped), palette);
+        }
+    }
+    // takes effect with the next recorded frame of each slot, like the cells.
+    void set_palette(const color_palette& new_palette) {
+        palette = new_palette;
+        for (auto& buffers : frame_buffers) {
+            buffers.palette_dirty = true;
+        }
+        refresh_occupancy();
+    }
+    // takes effect with the next recorded frame.
+    void set_clear_color(cell_color color) {
+        auto [r, g, b, a] = resolve_color(color, palette);
+        clear_color = vk::ClearColorValue{ r, g, b, a };
+        refresh_occupancy();
     }
     void create_per_swapchain_image_resources(auto& swapchainImages, auto color_format, auto depth_format) {
         auto device = parent::get_vulkan_device();
@@ -484,7 +1236,7 @@ public:
 
         vk::Format color_format = select_color_format(parent::get_vulkan_physical_device(), surface);
 
-        p_terminal_buffer = &terminal_buffer;
+        panes = { terminal_pane{ &terminal_buffer, vk::Rect2D{ vk::Offset2D{ 0, 0 }, swapchain_extent }, 0, 0, 0, nullptr, {} } };
 
         queue = get_queue(shared_device, queue_family_index);
 
@@ -493,15 +1245,34 @@ public:
 
 
         sampler = device.createSamplerUnique(vk::SamplerCreateInfo());
+        sdf_sampler = device.createSamplerUnique(
+            vk::SamplerCreateInfo{}
+            .setMagFilter(vk::Filter::eLinear)
+            .setMinFilter(vk::Filter::eLinear)
+            .setAddressModeU(vk::SamplerAddressMode::eClampToEdge)
+            .setAddressModeV(vk::SamplerAddressMode::eClampToEdge));
+
+
+        if constexpr (requires { parent::get_device_context(); }) {
+            pipeline_cache = parent::get_device_context()->get_pipeline_cache();
+            memory_pool = parent::get_device_context()->get_memory_pool();
+            uploads = parent::get_device_context()->get_upload_queue();
+        }
+        else {
+            pipeline_cache = vk::SharedPipelineCache{ device.createPipelineCache(vk::PipelineCacheCreateInfo{}), shared_device };
+            memory_pool = std::make_shared<vulkan::memory_pool>(parent::get_vulkan_shared_physical_device(), shared_device);
+            uploads = std::make_shared<upload_queue>(shared_device, queue_family_index,
+                vulkan::select_transfer_queue_family(physical_device, queue_family_index));
+        }
 
 
-        swapchain = create_swapchain(physical_device, shared_device, surface, surface_capabilities, color_format);
+        create_palette_buffer();
 
 
-        auto swapchainImages = device.getSwapchainImagesKHR(*swapchain);
+        swapchain = create_swapchain(physical_device, shared_device, surface, surface_capabilities, color_format);
 
 
-        command_pool = create_command_pool(shared_device, queue_family_index);
+        auto swapchainImages = device.getSwapchainImagesKHR(*swapchain);
 
 
         descriptor_pool = create_descriptor_pool(shared_device, descriptor_pool_size);
@@ -513,37 +1284,77 @@ public:
         create_per_swapchain_image_resources(swapchainImages, color_format, depth_format);
 
 
-        pipeline_layout = create_pipeline_layout(shared_device, descriptor_set_layout);
+        pipeline_layout = create_pipeline_layout(shared_device, descriptor_set_layout, create_push_constant_ranges());
+
+
+        overlay_pipeline_layout = create_overlay_pipeline_layout(shared_device);
 
 
-        descriptor_set = allocate_descriptor_set(shared_device, descriptor_set_layout);
+        overlay_pipeline = create_overlay_pipeline(shared_device, render_pass, overlay_pipeline_layout);
+
+
+        frame_descriptor_sets = allocate_frame_descriptor_sets(shared_device, descriptor_set_layout);
 
 
         create_and_update_terminal_buffer_relate_data(
-            descriptor_set, sampler, terminal_buffer, imageViews);
+            sampler, panes, imageViews);
     }
     void notify_update() {
-        create_and_update_terminal_buffer_relate_data(descriptor_set, sampler, *p_terminal_buffer,
+        create_and_update_terminal_buffer_relate_data(sampler, panes,
             imageViews);
     }
 
+    static constexpr uint32_t frames_in_flight = 3;
 protected:
-    multidimention_vector<uint32_t>* p_terminal_buffer;
-    vk::SharedCommandPool command_pool;
+    struct frame_descriptor_set {
+        vk::DescriptorSet descriptor_set;
+        uint64_t generation;
+        // what the set points to, held until the set is rewritten.
+        std::shared_ptr<void> resources;
+    };
+    std::vector<terminal_pane> panes;
     vk::SharedSwapchainKHR swapchain;
     vk::UniqueDescriptorPool descriptor_pool;
     vk::UniqueDescriptorSetLayout descriptor_set_layout;
-    vk::DescriptorSet descriptor_set;
+    std::vector<frame_descriptor_set> frame_descriptor_sets;
+    // bumped whenever the atlas or the cell buffers are replaced.
+    uint64_t resource_generation{ 0 };
+    // set by the renderer before init, mesh_pane_stages or vertex_pane_stages.
+    vk::ShaderStageFlags pane_stages{ vertex_pane_stages };
     vk::SharedRenderPass render_pass;
     vk::Extent2D swapchain_extent;
 
-    vk::SharedImage texture;
-    vk::SharedImageView texture_view;
-    vk::SharedDeviceMemory texture_memory;
-    multidimention_vector<uint32_t> char_indices;
-    vk::SharedBuffer char_indices_buffer;
-    vk::SharedDeviceMemory char_indices_buffer_memory;
+    std::shared_ptr<glyph_atlas> atlas;
+    // kept for every atlas rebuild, so the fallback faces stay open and each codepoint is looked up once.
+    font_loader fonts;
+    vk::SharedPipelineCache pipeline_cache;
+    std::shared_ptr<vulkan::memory_pool> memory_pool;
+    std::shared_ptr<upload_queue> uploads;
+    cell_update_queue update_queue;
+    // the cpu copies, what the frame buffers are brought up to.
+    std::vector<packed_cell> packed_cells;
+    std::vector<uint32_t> occupancy;
+    struct per_frame_buffers {
+        vk::SharedBuffer packed_cells_buffer;
+        std::shared_ptr<vulkan::memory_pool::allocation> packed_cells_allocation;
+        vk::SharedBuffer occupancy_buffer;
+        std::shared_ptr<vulkan::memory_pool::allocation> occupancy_allocation;
+        // first and count of the ranges changed since the frame last wrote these buffers.
+        std::vector<std::pair<uint32_t, uint32_t>> dirty_cells;
+        std::vector<std::pair<uint32_t, uint32_t>> dirty_occupancy;
+        // created once in init, only its contents follow set_palette.
+        vk::SharedBuffer palette_buffer;
+        std::shared_ptr<vulkan::memory_pool::allocation> palette_allocation;
+        bool palette_dirty{ false };
+    };
+    std::array<per_frame_buffers, frames_in_flight> frame_buffers;
+    color_palette palette{ generate_default_palette() };
+    vk::ClearColorValue clear_color{ 1.0f, 1.0f, 1.0f, 1.0f };
     vk::UniqueSampler sampler;
+    vk::UniqueSampler sdf_sampler;
+    bool sdf_atlas{ false };
+    // distance in atlas pixels between the outline and the ends of the distance range.
+    static constexpr float sdf_spread = 4.0f;
     std::vector<vk::SharedImageView> imageViews;
     std::vector<vk::UniqueSemaphore> render_complete_semaphores;
     std::vector<vk::SharedImage> depth_buffers;
@@ -553,40 +1364,103 @@ protected:
     vk::SharedQueue queue;
 
     vk::SharedPipelineLayout pipeline_layout;
-    uint32_t character_count;
+    vk::SharedPipelineLayout overlay_pipeline_layout;
+    vk::SharedPipeline overlay_pipeline;
+    std::array<float, 4> cursor_color{ 0.0f, 0.0f, 0.0f, 0.5f };
+    std::array<float, 4> selection_color{ 0.2f, 0.4f, 1.0f, 0.35f };
 };
 
 template<concept_helper::shared::device Device>
 class mesh_renderer : public vulkan_render_prepare<Device> {
 public:
     using parent = vulkan_render_prepare<Device>;
-    auto create_pipeline(auto render_pass, auto pipeline_layout, uint32_t character_count) {
+    mesh_renderer() {
+        parent::pane_stages = mesh_pane_stages;
+    }
+    // cells per mesh workgroup and its invocation count, picked from the device's mesh shader limits.
+    struct mesh_configuration {
+        uint32_t meshlet_cells;
+        uint32_t invocations;
+        uint32_t max_output_vertices;
+        uint32_t max_output_primitives;
+        uint32_t max_output_memory_size;
+        uint32_t max_preferred_invocations;
+    };
+    static mesh_configuration select_mesh_configuration(const vk::PhysicalDeviceMeshShaderPropertiesEXT& properties) {
+        // gl_Position and the 7 fragment outputs, each output takes a vec4 slot.
+        constexpr uint32_t vertex_output_size = 8 * 16;
+        constexpr uint32_t primitive_output_size = 16;
+        auto fits = [&properties](uint32_t cells) {
+            auto granularity = std::max(properties.meshOutputPerVertexGranularity, 1u);
+            auto vertices = (cells * 4 + granularity - 1) / granularity * granularity;
+            granularity = std::max(properties.meshOutputPerPrimitiveGranularity, 1u);
+            auto primitives = (cells * 2 + granularity - 1) / granularity * granularity;
+            return cells * 4 <= properties.maxMeshOutputVertices &&
+                cells * 2 <= properties.maxMeshOutputPrimitives &&
+                vertices * vertex_output_size + primitives * primitive_output_size <= properties.maxMeshOutputMemorySize;
+        };
+        uint32_t meshlet_cells = max_meshlet_cells;
+        while (meshlet_cells > occupancy_word_cells && !fits(meshlet_cells)) {
+            meshlet_cells /= 2;
+        }
+        auto invocation_limit = std::min({
+            properties.maxPreferredMeshWorkGroupInvocations, properties.maxMeshWorkGroupInvocations, meshlet_cells });
+        uint32_t invocations = 1;
+        while (invocations * 2 <= invocation_limit) {
+            invocations *= 2;
+        }
+        return mesh_configuration{
+            meshlet_cells, invocations,
+            properties.maxMeshOutputVertices, properties.maxMeshOutputPrimitives,
+            properties.maxMeshOutputMemorySize, properties.maxPreferredMeshWorkGroupInvocations,
+        };
+    }
+    const mesh_configuration& get_mesh_configuration() const {
+        return configuration;
+    }
+    // overrides the device derived choice, meshlet_cells must be one of the compiled variants, 32 or 64.
+    void set_mesh_configuration(uint32_t meshlet_cells, uint32_t invocations) {
+        assert(meshlet_cells == occupancy_word_cells || meshlet_cells == max_meshlet_cells);
+        configuration.meshlet_cells = meshlet_cells;
+        configuration.invocations = std::min({ invocations, meshlet_cells, configuration.max_preferred_invocations });
+        configuration_overridden = true;
+    }
+    auto create_pipeline(auto render_pass, auto pipeline_layout) {
         auto device = parent::get_vulkan_device();
         auto shared_device = parent::get_vulkan_shared_device();
-        vulkan::task_stage_info task_stage_info{
-            task_shader_path, "main",
-        };
-        class char_count_specialization {
+        if (!configuration_overridden) {
+            auto properties = parent::get_vulkan_physical_device().template getProperties2<
+                vk::PhysicalDeviceProperties2, vk::PhysicalDeviceMeshShaderPropertiesEXT>();
+            configuration = select_mesh_configuration(properties.template get<vk::PhysicalDeviceMeshShaderPropertiesEXT>());
+        }
+        // the mesh workgroup size, meshlet_cells sizes the mesh outputs so it picks the compiled variant.
+        class mesh_specialization {
         public:
-            char_count_specialization(uint32_t character_count)
+            mesh_specialization(const mesh_configuration& configuration)
                 :
-                m_count{ character_count },
-                map_entry{ vk::SpecializationMapEntry{}.setConstantID(555).setOffset(0).setSize(sizeof(m_count)) },
+                m_values{ configuration.invocations },
+                map_entries{
+                    vk::SpecializationMapEntry{}.setConstantID(557).setOffset(0).setSize(sizeof(uint32_t)),
+                },
                 specialization_info{ vk::SpecializationInfo{}
-                .setMapEntries(map_entry).setDataSize(sizeof(m_count)).setPData(&this->m_count) }
+                .setMapEntries(map_entries).setDataSize(sizeof(m_values)).setPData(m_values.data()) }
             {
             }
         public:
-            uint32_t m_count;
-            vk::SpecializationMapEntry map_entry;
+            std::array<uint32_t, 1> m_values;
+            std::array<vk::SpecializationMapEntry, 1> map_entries;
             vk::SpecializationInfo specialization_info;
         };
-        char_count_specialization specialization{
-            character_count
+        mesh_specialization specialization{
+            configuration
         };
+        bool large_meshlets = configuration.meshlet_cells == max_meshlet_cells;
 
+        vulkan::task_stage_info task_stage_info{
+            large_meshlets ? task_meshlet64_shader_path : task_meshlet32_shader_path, "main", specialization.specialization_info
+        };
         vulkan::mesh_stage_info mesh_stage_info{
-            mesh_shader_path, "main", specialization.specialization_info
+            large_meshlets ? mesh_meshlet64_shader_path : mesh_meshlet32_shader_path, "main", specialization.specialization_info
         };
         vulkan::geometry_stage_info geometry_stage_info{
             geometry_shader_path, "main",
@@ -595,30 +1469,36 @@ public:
             vulkan::create_pipeline(device,
                     task_stage_info,
                     mesh_stage_info,
-                    fragment_shader_path, *render_pass, *pipeline_layout).value, shared_device };
+                    parent::atlas->is_sdf ? fragment_sdf_shader_path : fragment_shader_path,
+                    *render_pass, *pipeline_layout, *parent::pipeline_cache).value, shared_device };
     }
     void create_and_update_terminal_buffer_relate_data() {
         parent::create_and_update_terminal_buffer_relate_data(
-            parent::descriptor_set, parent::sampler, *parent::p_terminal_buffer, parent::imageViews
+            parent::sampler, parent::panes, parent::imageViews
         );
-        pipeline = create_pipeline(parent::render_pass, parent::pipeline_layout, parent::character_count);
-        vk::detail::DispatchLoaderDynamic dldid(parent::get_vulkan_instance(), vkGetInstanceProcAddr, parent::get_vulkan_device());
-        for (integer_less_equal<decltype(parent::imageViews.size())> i{ 0, parent::imageViews.size() }; i < parent::imageViews.size(); i++) {
-            simple_draw_command draw_command{
-                command_buffers[i],
-                *parent::render_pass,
-                *parent::pipeline_layout,
-                *pipeline,
-                parent::descriptor_set,
-                *parent::framebuffers[i],
-                parent::swapchain_extent, dldid };
+        // glyph placement comes from the atlas' glyph rects, only the fragment shader depends on the atlas.
+        if (!pipeline || pipeline_is_sdf != parent::atlas->is_sdf) {
+            pipeline = create_pipeline(parent::render_pass, parent::pipeline_layout);
+            pipeline_is_sdf = parent::atlas->is_sdf;
         }
     }
+    // records the draw commands of one frame to the swapchain image, pane sizes and viewports are read now.
+    // frame_index is the frame in flight, its previous commands have finished.
+    void record_frame(vk::CommandBuffer cmd, uint32_t image_index, uint32_t frame_index) {
+        frame_pipelines[frame_index] = pipeline;
+        simple_draw_command draw_command{
+            cmd,
+            *parent::render_pass,
+            *parent::pipeline_layout,
+            *pipeline,
+            parent::get_frame_descriptor_set(frame_index),
+            *parent::framebuffers[image_index],
+            parent::swapchain_extent, parent::clear_color, parent::get_pane_draw_infos(),
+            [this](vk::CommandBuffer cmd) { parent::record_overlays(cmd); }, dldid };
+    }
     void init(auto& terminal_buffer) {
         parent::init(terminal_buffer);
-        vk::CommandBufferAllocateInfo commandBufferAllocateInfo(
-            *parent::command_pool, vk::CommandBufferLevel::ePrimary, parent::imageViews.size());
-        command_buffers = parent::get_vulkan_device().allocateCommandBuffers(commandBufferAllocateInfo);
+        dldid = vk::detail::DispatchLoaderDynamic(parent::get_vulkan_instance(), vkGetInstanceProcAddr, parent::get_vulkan_device());
         create_and_update_terminal_buffer_relate_data();
     }
     void notify_update() {
@@ -626,101 +1506,61 @@ public:
     }
 protected:
     vk::SharedPipeline pipeline;
-    std::vector<vk::CommandBuffer> command_buffers;
+    bool pipeline_is_sdf{ false };
+    // the pipeline each frame in flight was recorded with, a replaced one lives until its frames finish.
+    std::array<vk::SharedPipeline, parent::frames_in_flight> frame_pipelines;
+    vk::detail::DispatchLoaderDynamic dldid;
+    mesh_configuration configuration{};
+    bool configuration_overridden{ false };
 };
 
 template<vulkan_helper::concept_helper::instance Instance>
 class vertex_renderer : public vulkan_render_prepare<Instance> {
 public:
     using parent = vulkan_render_prepare<Instance>;
-    struct vertex {
-        float x, y, z, w;
-    };
-    auto create_pipeline(auto device, auto render_pass, auto pipeline_layout, uint32_t character_count) {
-        class char_count_specialization {
-        public:
-            char_count_specialization(uint32_t character_count)
-                :
-                m_count{ character_count },
-                map_entry{ vk::SpecializationMapEntry{}.setConstantID(555).setOffset(0).setSize(sizeof(m_count)) },
-                specialization_info{ vk::SpecializationInfo{}
-                .setMapEntries(map_entry).setDataSize(sizeof(m_count)).setPData(&this->m_count) }
-            {
-            }
-        public:
-            uint32_t m_count;
-            vk::SpecializationMapEntry map_entry;
-            vk::SpecializationInfo specialization_info;
-        };
-        char_count_specialization specialization{
-            character_count
-        };
+    vertex_renderer() {
+        parent::pane_stages = vertex_pane_stages;
+    }
+    auto create_pipeline(auto device, auto render_pass, auto pipeline_layout) {
+        // vertex.glsl generates the cell quads from gl_VertexIndex, no vertex input.
         vulkan::vertex_stage_info vertex_stage_info{
             vertex_shader_path, "main",
-            vk::VertexInputBindingDescription{}.setBinding(0).setInputRate(vk::VertexInputRate::eVertex).setStride(sizeof(vertex)),
-            std::vector{
-                vk::VertexInputAttributeDescription{}.setBinding(0).setLocation(0).setOffset(0).setFormat(vk::Format::eR32G32B32A32Sfloat)
-            },
-            specialization.specialization_info
+            {},
+            {},
         };
         return vk::SharedPipeline{
             vulkan::create_pipeline(*device,
                     vertex_stage_info,
-                    fragment_shader_path, *render_pass, *pipeline_layout).value, device };
-    }
-    void create_vertex_buffer(auto&& vertices) {
-        auto physical_device = parent::get_vulkan_physical_device();
-        auto device = parent::get_vulkan_device();
-        auto shared_device = parent::get_vulkan_shared_device();
-        auto [buffer, memory, memory_size] = vulkan::create_vertex_buffer(physical_device, device, vertices);
-        vertex_buffer = vk::SharedBuffer{ buffer, shared_device};
-        vertex_buffer_memory = vk::SharedDeviceMemory{ memory, shared_device};
+                    parent::atlas->is_sdf ? fragment_sdf_shader_path : fragment_shader_path,
+                    *render_pass, *pipeline_layout, *parent::pipeline_cache).value, device };
     }
     void create_and_update_terminal_buffer_relate_data() {
         auto device = parent::get_vulkan_shared_device();
         parent::create_and_update_terminal_buffer_relate_data(
-            parent::descriptor_set, parent::sampler, *parent::p_terminal_buffer, parent::imageViews
+            parent::sampler, parent::panes, parent::imageViews
         );
-        std::vector<vertex> vertices{};
-        auto& terminal_buffer = *parent::p_terminal_buffer;
-        for (int y = 0; y < terminal_buffer.get_dim1_size(); y++) {
-            for (int x = 0; x < terminal_buffer.get_dim0_size(); x++) {
-                float width = 2.0f / terminal_buffer.get_dim0_size();
-                float height = 2.0f / terminal_buffer.get_dim1_size();
-                float s_x = -1 + x * width;
-                float s_y = -1 + y * height;
-                auto index = parent::char_indices[std::pair{ x, y }];
-                const float tex_width = 1.0 / parent::character_count;
-                const float tex_advance = tex_width;
-                const float tex_offset = tex_width * index;
-                vertices.push_back(vertex{ s_x, s_y, tex_offset, 0 });
-                vertices.push_back(vertex{ s_x + width, s_y, tex_offset + tex_advance, 0 });
-                vertices.push_back(vertex{ s_x, s_y + height, tex_offset, 1 });
-                vertices.push_back(vertex{ s_x, s_y + height, tex_offset, 1 });
-                vertices.push_back(vertex{ s_x + width, s_y, tex_offset + tex_advance, 0 });
-                vertices.push_back(vertex{ s_x + width,s_y + height, tex_offset + tex_advance, 1 });
-            }
-        }
-        create_vertex_buffer(vertices);
-        pipeline = create_pipeline(device, parent::render_pass, parent::pipeline_layout, parent::character_count);
-        vk::detail::DispatchLoaderDynamic dldid(parent::get_vulkan_instance(), vkGetInstanceProcAddr, *device);
-        for (integer_less_equal<decltype(parent::imageViews.size())> i{ 0, parent::imageViews.size() }; i < parent::imageViews.size(); i++) {
-            record_draw_command(
-                command_buffers[i],
-                *parent::render_pass,
-                *parent::pipeline_layout,
-                *pipeline,
-                parent::descriptor_set,
-                *parent::framebuffers[i],
-                parent::swapchain_extent, dldid);
+        // glyph placement comes from the atlas' glyph rects, only the fragment shader depends on the atlas.
+        if (!pipeline || pipeline_is_sdf != parent::atlas->is_sdf) {
+            pipeline = create_pipeline(device, parent::render_pass, parent::pipeline_layout);
+            pipeline_is_sdf = parent::atlas->is_sdf;
         }
     }
+    // records the draw commands of one frame to the swapchain image, pane sizes and viewports are read now.
+    // frame_index is the frame in flight, its previous commands have finished.
+    void record_frame(vk::CommandBuffer cmd, uint32_t image_index, uint32_t frame_index) {
+        frame_pipelines[frame_index] = pipeline;
+        auto pane_draw_infos = parent::get_pane_draw_infos();
+        record_draw_command(
+            cmd,
+            *parent::render_pass,
+            *parent::pipeline_layout,
+            *pipeline,
+            parent::get_frame_descriptor_set(frame_index),
+            *parent::framebuffers[image_index],
+            parent::swapchain_extent, pane_draw_infos);
+    }
     void init(auto& terminal_buffer) {
-        auto device = parent::get_vulkan_device();
         parent::init(terminal_buffer);
-        vk::CommandBufferAllocateInfo commandBufferAllocateInfo(
-            *parent::command_pool, vk::CommandBufferLevel::ePrimary, parent::imageViews.size());
-        command_buffers = device.allocateCommandBuffers(commandBufferAllocateInfo);
         create_and_update_terminal_buffer_relate_data();
     }
     void notify_update() {
@@ -735,12 +1575,12 @@ public:
             vk::DescriptorSet descriptor_set,
             vk::Framebuffer framebuffer,
             vk::Extent2D swapchain_extent,
-            vk::detail::DispatchLoaderDynamic dldid)
+            std::span<const pane_draw_info> panes)
     {
-            vk::CommandBufferBeginInfo begin_info{ vk::CommandBufferUsageFlagBits::eSimultaneousUse };
+            vk::CommandBufferBeginInfo begin_info{ vk::CommandBufferUsageFlagBits::eOneTimeSubmit };
             cmd.begin(begin_info);
             std::array<vk::ClearValue, 2> clear_values;
-            clear_values[0].color = vk::ClearColorValue{ 1.0f, 1.0f,1.0f,1.0f };
+            clear_values[0].color = parent::clear_color;
             clear_values[1].depthStencil = vk::ClearDepthStencilValue{ 1.0f, 0 };
             vk::RenderPassBeginInfo render_pass_begin_info{
                 render_pass, framebuffer,
@@ -751,95 +1591,260 @@ public:
                 pipeline);
             cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics,
                 pipeline_layout, 0, descriptor_set, nullptr);
-            cmd.bindVertexBuffers(0, *vertex_buffer, { 0 });
-            cmd.bindVertexBuffers(1, *parent::char_indices_buffer, { 0 });
-            cmd.setViewport(0, vk::Viewport(0, 0, swapchain_extent.width, swapchain_extent.height, 0, 1));
-            cmd.setScissor(0, vk::Rect2D(vk::Offset2D(0, 0), swapchain_extent));
-            cmd.draw(parent::p_terminal_buffer->size()*6, 1, 0, 0);
+            for (auto& pane : panes) {
+                cmd.setViewport(0, vk::Viewport(pane.viewport.offset.x, pane.viewport.offset.y, pane.viewport.extent.width, pane.viewport.extent.height, 0, 1));
+                cmd.setScissor(0, pane.viewport);
+                cmd.pushConstants<pane_push_constants>(pipeline_layout, vertex_pane_stages, 0, pane.push_constants);
+                cmd.draw(pane.push_constants.width * pane.push_constants.height * 6, 1, 0, 0);
+            }
+            parent::record_overlays(cmd);
             cmd.endRenderPass();
             cmd.end();
     }
 protected:
     vk::SharedPipeline pipeline;
-    std::vector<vk::CommandBuffer> command_buffers;
-
-    vk::SharedBuffer vertex_buffer;
-    vk::SharedDeviceMemory vertex_buffer_memory;
-    vk::SharedBufferView vertex_buffer_view;
+    bool pipeline_is_sdf{ false };
+    // the pipeline each frame in flight was recorded with, a replaced one lives until its frames finish.
+    std::array<vk::SharedPipeline, parent::frames_in_flight> frame_pipelines;
 };
 
 template<class Renderer>
 class renderer_presenter : public Renderer {
 public:
     using parent = Renderer;
-    void set_texture_image_layout() {
-        auto device = parent::get_vulkan_device();
-        auto texture_prepare_semaphore = present_manager->get_next();
-        {
-            vk::UniqueCommandBuffer init_command_buffer{
-                std::move(device.allocateCommandBuffersUnique(vk::CommandBufferAllocateInfo{}.setCommandBufferCount(1).setCommandPool(*Renderer::command_pool)).front()) };
-            init_command_buffer->begin(vk::CommandBufferBeginInfo{});
-            vulkan::set_image_layout(*init_command_buffer, *Renderer::texture, vk::ImageAspectFlagBits::eColor, vk::ImageLayout::ePreinitialized,
-                vk::ImageLayout::eShaderReadOnlyOptimal, vk::AccessFlagBits(), vk::PipelineStageFlagBits::eTopOfPipe,
-                vk::PipelineStageFlagBits::eFragmentShader);
-            auto& cmd = init_command_buffer;
-            cmd->end();
-            auto signal_semaphore = texture_prepare_semaphore.semaphore;
-            auto command_submit_info = vk::CommandBufferSubmitInfo{}.setCommandBuffer(*cmd);
-            auto signal_semaphore_info = vk::SemaphoreSubmitInfo{}.setSemaphore(signal_semaphore).setStageMask(vk::PipelineStageFlagBits2::eTransfer);
-            Renderer::queue->submit2(vk::SubmitInfo2{}.setCommandBufferInfos(command_submit_info).setSignalSemaphoreInfos(signal_semaphore_info));
-            Renderer::queue->submit2(vk::SubmitInfo2{}.setWaitSemaphoreInfos(signal_semaphore_info), texture_prepare_semaphore.fence);
-            auto res = device.waitForFences(std::array<vk::Fence, 1>{texture_prepare_semaphore.fence}, true, UINT64_MAX);
-            assert(res == vk::Result::eSuccess);
+    // the graphics queue takes the atlas over from the upload queue, frames submitted after it sample the texture.
+    // uploads on the graphics queue itself are ordered before the frames already.
+    void acquire_atlas() {
+        auto& atlas = Renderer::atlas;
+        if (atlas->acquired) {
+            return;
+        }
+        // an atlas of a device_context is shared, the first of its presenters acquires it.
+        std::unique_lock<std::mutex> atlas_lock;
+        if constexpr (requires { parent::get_device_context(); }) {
+            atlas_lock = parent::get_device_context()->lock_glyph_atlas();
+            if (atlas->acquired) {
+                return;
+            }
+        }
+        auto& uploads = Renderer::uploads;
+        if (uploads->is_dedicated()) {
+            auto value = frames->reserve_value();
+            frames->signal(value);
+            uploads->acquire(*Renderer::queue, atlas->upload_value, [&atlas, &uploads](vk::CommandBuffer cmd) {
+                vulkan::record_texture_acquire(cmd, *atlas->texture, atlas->layers,
+                    uploads->get_queue_family_index(), uploads->get_graphics_queue_family_index());
+                }, frames->get_semaphore(), value);
         }
+        atlas->acquired = true;
     }
     void init(auto& terminal_buffer) {
         Renderer::init(terminal_buffer);
-        present_manager = std::make_shared<vulkan::present_manager>(parent::get_vulkan_shared_device(), 10);
-        set_texture_image_layout();
+        frames = std::make_shared<vulkan::frame_timeline>(parent::get_vulkan_shared_device(), frames_in_flight);
+        frame_commands.clear();
+        for (uint32_t i = 0; i < frames_in_flight; i++) {
+            auto pool = vulkan::shared::create_transient_command_pool(parent::get_vulkan_shared_device(), parent::get_queue_family_index());
+            auto command_buffer = parent::get_vulkan_device().allocateCommandBuffers(
+                vk::CommandBufferAllocateInfo{ *pool, vk::CommandBufferLevel::ePrimary, 1 }).front();
+            frame_commands.emplace_back(per_frame_commands{ pool, command_buffer });
+        }
+        acquire_atlas();
     }
+    // drain_updates only writes the cpu copies, the frame's own buffers catch up in record_frame after begin_frame.
     run_result run()
     {
-        auto reused_acquire_image_semaphore = present_manager->get_next();
+        using clock = std::chrono::steady_clock;
+        auto update_start = clock::now();
+        if (!Renderer::drain_updates()) {
+            notify_update();
+        }
+        auto update_time = clock::now() - update_start;
+        auto frame = frames->begin_frame();
         auto image_index = parent::get_vulkan_device().acquireNextImageKHR(
             *Renderer::swapchain, UINT64_MAX,
-            reused_acquire_image_semaphore.semaphore)
+            frame.acquire_semaphore)
             .value;
+        frames->acquired(frame);
+        auto record_start = clock::now();
 
         auto& render_complete_semaphore = Renderer::render_complete_semaphores[image_index];
-        auto& command_buffer = Renderer::command_buffers[image_index];
+        // begin_frame waited for the frame that used this slot before, its commands can be dropped.
+        auto& commands = frame_commands[frame.index];
+        parent::get_vulkan_device().resetCommandPool(*commands.pool);
+        auto command_buffer = commands.command_buffer;
+        Renderer::record_frame(command_buffer, image_index, frame.index);
 
         {
             auto wait_semaphore_infos = std::array{
                 vk::SemaphoreSubmitInfo{}
-                    .setSemaphore(reused_acquire_image_semaphore.semaphore)
+                    .setSemaphore(frame.acquire_semaphore)
                     .setStageMask(vk::PipelineStageFlagBits2::eColorAttachmentOutput),
             };
             auto submit_cmd_info = vk::CommandBufferSubmitInfo{}.setCommandBuffer(command_buffer);
-            auto signal_semaphore_info = vk::SemaphoreSubmitInfo{}.setSemaphore(*render_complete_semaphore).setStageMask(vk::PipelineStageFlagBits2::eAllCommands);
+            auto signal_semaphore_infos = std::array{
+                vk::SemaphoreSubmitInfo{}.setSemaphore(*render_complete_semaphore).setStageMask(vk::PipelineStageFlagBits2::eAllCommands),
+                frames->signal(frame.value),
+            };
+            auto queue_lock = Renderer::uploads->lock_queues();
             Renderer::queue->submit2(
                 vk::SubmitInfo2{}
                 .setWaitSemaphoreInfos(wait_semaphore_infos)
                 .setCommandBufferInfos(submit_cmd_info)
-                .setSignalSemaphoreInfos(signal_semaphore_info),
-                reused_acquire_image_semaphore.fence);
+                .setSignalSemaphoreInfos(signal_semaphore_infos));
         }
+        last_frame_work_time = update_time + (clock::now() - record_start);
 
         {
             std::array<vk::Semaphore, 1> wait_semaphores{ *render_complete_semaphore };
             std::array<vk::SwapchainKHR, 1> swapchains{ *Renderer::swapchain };
             std::array<uint32_t, 1> indices{ image_index };
             vk::PresentInfoKHR present_info{ wait_semaphores, swapchains, indices };
+            auto queue_lock = Renderer::uploads->lock_queues();
             auto res = Renderer::queue->presentKHR(present_info);
             assert(res == vk::Result::eSuccess || res == vk::Result::eSuboptimalKHR);
         }
         return run_result::eContinue;
     }
+    // the frames in flight keep the buffers, atlas and pipeline they were recorded with, and no slot's buffers
+    // are written before its frame finished, so nothing is waited for.
     void notify_update() {
-        present_manager->wait_all();
         Renderer::notify_update();
-        set_texture_image_layout();
+        acquire_atlas();
+    }
+    // only the pane's range of the cell buffer is rewritten, unless the pane brings new glyphs or a new size.
+    void notify_pane_update(size_t pane_index) {
+        if (!Renderer::update_pane_cells(pane_index)) {
+            notify_update();
+        }
+    }
+    // cpu time of the last run spent draining updates, recording and submitting. The waits for a free frame,
+    // for the swapchain image and for present are left out, with FIFO they only measure the display rate.
+    std::chrono::nanoseconds get_last_frame_work_time() const {
+        return last_frame_work_time;
+    }
+private:
+    using Renderer::frames_in_flight;
+    struct per_frame_commands {
+        vk::SharedCommandPool pool;
+        vk::CommandBuffer command_buffer;
+    };
+    std::vector<per_frame_commands> frame_commands;
+    std::chrono::nanoseconds last_frame_work_time{};
+    // declared last so it waits for the frames before the pools go.
+    std::shared_ptr<vulkan::frame_timeline> frames;
+};
+
+// Chooses between two presenter chains at runtime. The mesh chain is built first, it checks the device it
+// selected before creating a logical device and throws mesh_shader_unsupported when the device has no task
+// and mesh shaders, then the vertex chain is built instead. Both chains select the same device.
+template<class MeshPresenter, class VertexPresenter>
+class runtime_selected_presenter {
+public:
+    runtime_selected_presenter()
+        : m_presenter{ create_presenter() } {}
+    bool is_mesh_path() const {
+        return std::holds_alternative<std::unique_ptr<MeshPresenter>>(m_presenter);
+    }
+    // runs f on whichever presenter was chosen, for calls beyond the common ones below.
+    decltype(auto) visit(auto&& f) {
+        return std::visit([&f](auto& presenter) -> decltype(auto) { return f(*presenter); }, m_presenter);
+    }
+    void init(auto& terminal_buffer) {
+        visit([&terminal_buffer](auto& presenter) { presenter.init(terminal_buffer); });
+    }
+    run_result run() {
+        return visit([](auto& presenter) { return presenter.run(); });
+    }
+    void notify_update() {
+        visit([](auto& presenter) { presenter.notify_update(); });
+    }
+    void notify_pane_update(size_t pane_index) {
+        visit([pane_index](auto& presenter) { presenter.notify_pane_update(pane_index); });
+    }
+    cell_update_queue& get_update_queue() {
+        return visit([](auto& presenter) -> cell_update_queue& { return presenter.get_update_queue(); });
+    }
+    uint64_t get_upload_count() {
+        return visit([](auto& presenter) { return presenter.get_upload_count(); });
+    }
+    std::chrono::nanoseconds get_last_frame_work_time() {
+        return visit([](auto& presenter) { return presenter.get_last_frame_work_time(); });
     }
 private:
-    std::shared_ptr<vulkan::present_manager> present_manager;
+    using presenter_variant = std::variant<std::unique_ptr<MeshPresenter>, std::unique_ptr<VertexPresenter>>;
+    static presenter_variant create_presenter() {
+        try {
+            return presenter_variant{ std::make_unique<MeshPresenter>() };
+        }
+        catch (const vulkan::mesh_shader_unsupported&) {
+            return presenter_variant{ std::make_unique<VertexPresenter>() };
+        }
+    }
+    presenter_variant m_presenter;
+};
+
+// Owns the render thread. Producers only publish cell updates or snapshots and call request_frame,
+// any number of requests between two frames are coalesced into one. The swapchain presents with
+// FIFO, so the frame rate is capped at the display rate while ingest runs at its own speed.
+template<class Presenter>
+class threaded_presenter : public Presenter {
+public:
+    using parent = Presenter;
+    threaded_presenter() : m_frame_requested{ false }, m_stop{ false } {}
+    ~threaded_presenter() {
+        stop();
+    }
+    void start() {
+        m_thread = std::thread{ [this]() { render_loop(); } };
+    }
+    void stop() {
+        if (!m_thread.joinable()) {
+            return;
+        }
+        m_stop = true;
+        request_frame();
+        m_thread.join();
+    }
+    // never blocks, safe to call from any thread.
+    void request_frame() {
+        if (!m_frame_requested.exchange(true, std::memory_order_release)) {
+            m_frame_requested.notify_one();
+        }
+    }
+    // runs f on the render thread before the next frame, for pane or palette changes.
+    void post(std::function<void()> f) {
+        {
+            std::lock_guard lock{ m_tasks_mutex };
+            m_tasks.emplace_back(std::move(f));
+        }
+        request_frame();
+    }
+private:
+    void render_loop() {
+        while (true) {
+            // taking the request and clearing it is one step, a request_frame in between is not lost.
+            while (!m_frame_requested.exchange(false, std::memory_order_acq_rel)) {
+                m_frame_requested.wait(false, std::memory_order_acquire);
+            }
+            if (m_stop) {
+                break;
+            }
+            std::vector<std::function<void()>> tasks;
+            {
+                std::lock_guard lock{ m_tasks_mutex };
+                tasks.swap(m_tasks);
+            }
+            for (auto& task : tasks) {
+                task();
+            }
+            if (parent::run() == run_result::eBreak) {
+                break;
+            }
+        }
+    }
+    std::atomic<bool> m_frame_requested;
+    std::atomic<bool> m_stop;
+    std::mutex m_tasks_mutex;
+    std::vector<std::function<void()>> m_tasks;
+    std::thread m_thread;
 };
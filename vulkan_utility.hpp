@@ -13,11 +13,16 @@
 #include <ranges>
 #include <filesystem>
 #include <set>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
 
 #define max max
 #include "spirv_reader.hpp"
 #include "shader_path.hpp"
 #include "multidimention_array.hpp"
+#include "terminal_cell.hpp"
 #include "font_loader.hpp"
 #include "run_result.hpp"
 #include "helper.hpp"
@@ -91,19 +96,123 @@ template<class T>
 inline constexpr bool std::ranges::enable_borrowed_range<from_0_count_n<T>> = true;
 
 namespace vulkan {
-    inline auto select_physical_device(vk::Instance instance) {
+    inline bool supports_device_extensions(vk::PhysicalDevice physical_device, const std::vector<std::string>& extensions) {
+        auto properties = physical_device.enumerateDeviceExtensionProperties();
+        return std::ranges::all_of(extensions, [&properties](auto& extension) {
+            return std::ranges::any_of(properties, [&extension](auto& property) {
+                return extension == property.extensionName.data();
+                });
+            });
+    }
+    // thrown while a mesh renderer chain creates its device on a physical device without task and mesh shaders.
+    class mesh_shader_unsupported : public std::runtime_error {
+    public:
+        mesh_shader_unsupported() : std::runtime_error{ "the physical device has no task and mesh shaders" } {}
+    };
+    inline bool supports_mesh_shader(vk::PhysicalDevice physical_device) {
+        if (!supports_device_extensions(physical_device, { vk::EXTMeshShaderExtensionName })) {
+            return false;
+        }
+        auto features = physical_device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceMeshShaderFeaturesEXT>();
+        auto& mesh_features = features.get<vk::PhysicalDeviceMeshShaderFeaturesEXT>();
+        return mesh_features.meshShader && mesh_features.taskShader;
+    }
+    // the first family with graphics that can also present to surface, any graphics family without a surface.
+    inline std::optional<uint32_t> find_graphics_queue_family(vk::PhysicalDevice physical_device, vk::SurfaceKHR surface = {}) {
+        auto queue_families = physical_device.getQueueFamilyProperties();
+        for (uint32_t i = 0; i < queue_families.size(); i++) {
+            if ((queue_families[i].queueFlags & vk::QueueFlagBits::eGraphics) &&
+                (!surface || physical_device.getSurfaceSupportKHR(i, surface))) {
+                return i;
+            }
+        }
+        return std::nullopt;
+    }
+    // nullopt if the renderers cannot run on the device at all: Vulkan 1.3 with synchronization2 and maintenance4,
+    // the required extensions and a queue family find_graphics_queue_family accepts. Otherwise higher is better,
+    // the device type weighs most, then mesh shader support, then device local memory.
+    inline std::optional<uint64_t> score_physical_device(vk::PhysicalDevice physical_device, const std::vector<std::string>& required_extensions,
+        vk::SurfaceKHR surface = {}) {
+        auto properties = physical_device.getProperties();
+        if (properties.apiVersion < VK_API_VERSION_1_3 || !supports_device_extensions(physical_device, required_extensions)) {
+            return std::nullopt;
+        }
+        auto features = physical_device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan13Features>();
+        auto& features13 = features.get<vk::PhysicalDeviceVulkan13Features>();
+        if (!features13.synchronization2 || !features13.maintenance4) {
+            return std::nullopt;
+        }
+        if (!find_graphics_queue_family(physical_device, surface)) {
+            return std::nullopt;
+        }
+        uint64_t type_score = 0;
+        switch (properties.deviceType) {
+        case vk::PhysicalDeviceType::eDiscreteGpu: type_score = 4; break;
+        case vk::PhysicalDeviceType::eIntegratedGpu: type_score = 3; break;
+        case vk::PhysicalDeviceType::eVirtualGpu: type_score = 2; break;
+        case vk::PhysicalDeviceType::eOther: type_score = 1; break;
+        default: type_score = 0; break;
+        }
+        auto memory_properties = physical_device.getMemoryProperties();
+        uint64_t device_local_mib = 0;
+        for (uint32_t i = 0; i < memory_properties.memoryHeapCount; i++) {
+            if (memory_properties.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal) {
+                device_local_mib += memory_properties.memoryHeaps[i].size >> 20;
+            }
+        }
+        return type_score << 40 | uint64_t{ supports_mesh_shader(physical_device) } << 39 |
+            std::min<uint64_t>(device_local_mib, (uint64_t{ 1 } << 39) - 1);
+    }
+    // the best scored device, enumeration order breaks ties.
+    inline auto select_physical_device(vk::Instance instance, vk::SurfaceKHR surface = {},
+        const std::vector<std::string>& required_extensions = { vk::KHRSwapchainExtensionName }) {
         auto devices = instance.enumeratePhysicalDevices();
-        return devices.front();
-    }
-    inline auto select_queue_family(vk::PhysicalDevice physical_device) {
-        uint32_t graphicsQueueFamilyIndex = 0;
-        auto queueFamilyProperties = physical_device.getQueueFamilyProperties();
-        for (int i = 0; i < queueFamilyProperties.size(); i++) {
-            if (queueFamilyProperties[i].queueFlags & vk::QueueFlagBits::eGraphics) {
-                graphicsQueueFamilyIndex = i;
+        std::optional<vk::PhysicalDevice> selected_device;
+        uint64_t selected_score = 0;
+        for (auto device : devices) {
+            auto score = score_physical_device(device, required_extensions, surface);
+            if (score && (!selected_device || *score > selected_score)) {
+                selected_device = device;
+                selected_score = *score;
             }
         }
-        return graphicsQueueFamilyIndex;
+        if (!selected_device) {
+            throw std::runtime_error{ "no physical device can run the renderer" };
+        }
+        return *selected_device;
+    }
+    // the family score_physical_device found for the device.
+    inline uint32_t select_queue_family(vk::PhysicalDevice physical_device, vk::SurfaceKHR surface = {}) {
+        auto family = find_graphics_queue_family(physical_device, surface);
+        if (!family) {
+            throw std::runtime_error{ "no queue family can draw and present" };
+        }
+        return *family;
+    }
+    // a family other than graphics_queue_family_index that can copy into images at any offset,
+    // preferring a pure transfer family (a DMA engine) over an async compute family.
+    inline std::optional<uint32_t> select_transfer_queue_family(vk::PhysicalDevice physical_device, uint32_t graphics_queue_family_index) {
+        auto queue_family_properties = physical_device.getQueueFamilyProperties();
+        assert(graphics_queue_family_index < queue_family_properties.size() &&
+            (queue_family_properties[graphics_queue_family_index].queueFlags & vk::QueueFlagBits::eGraphics));
+        std::optional<uint32_t> selected_family;
+        for (uint32_t i = 0; i < queue_family_properties.size(); i++) {
+            auto& family = queue_family_properties[i];
+            auto granularity = family.minImageTransferGranularity;
+            if (i == graphics_queue_family_index || family.queueCount == 0 ||
+                (family.queueFlags & vk::QueueFlagBits::eGraphics) ||
+                !(family.queueFlags & (vk::QueueFlagBits::eTransfer | vk::QueueFlagBits::eCompute)) ||
+                granularity.width != 1 || granularity.height != 1) {
+                continue;
+            }
+            if (!(family.queueFlags & vk::QueueFlagBits::eCompute)) {
+                return i;
+            }
+            if (!selected_family) {
+                selected_family = i;
+            }
+        }
+        return selected_family;
     }
     inline auto select_depth_image_tiling(vk::PhysicalDevice physical_device, vk::Format format) {
         vk::FormatProperties format_properties = physical_device.getFormatProperties(format);
@@ -121,6 +230,10 @@ namespace vulkan {
         vk::ImageCreateInfo create_info{ {}, type, format, vk::Extent3D{extent, 1}, 1, 1, vk::SampleCountFlagBits::e1, tiling, usages };
         return device.createImage(create_info);
     }
+    inline auto create_array_image(vk::Device device, vk::Format format, vk::Extent2D extent, uint32_t layers, vk::ImageTiling tiling, vk::ImageUsageFlags usages) {
+        vk::ImageCreateInfo create_info{ {}, vk::ImageType::e2D, format, vk::Extent3D{extent, 1}, 1, layers, vk::SampleCountFlagBits::e1, tiling, usages };
+        return device.createImage(create_info);
+    }
     inline auto create_image(vk::Device device, vk::ImageType type, vk::Format format, vk::Extent2D extent, vk::ImageTiling tiling, vk::ImageUsageFlags usages, vk::ImageLayout layout) {
         auto create_info = vk::ImageCreateInfo{ {}, type, format, vk::Extent3D{extent, 1}, 1, 1, vk::SampleCountFlagBits::e1, tiling, usages }
         .setInitialLayout(layout);
@@ -157,6 +270,9 @@ namespace vulkan {
     inline auto create_image_view(vk::Device device, vk::Image image, vk::ImageViewType type, vk::Format format, vk::ImageAspectFlags aspect) {
         return device.createImageView(vk::ImageViewCreateInfo{ {}, image, type, format, {}, {aspect, 0, 1, 0, 1} });
     }
+    inline auto create_array_image_view(vk::Device device, vk::Image image, vk::Format format, vk::ImageAspectFlags aspect, uint32_t layers) {
+        return device.createImageView(vk::ImageViewCreateInfo{ {}, image, vk::ImageViewType::e2DArray, format, {}, {aspect, 0, 1, 0, layers} });
+    }
     inline auto create_depth_buffer(vk::PhysicalDevice physical_device, vk::Device device, vk::Format format, vk::Extent2D extent) {
         vk::ImageTiling tiling = select_depth_image_tiling(physical_device, format);
         auto image = create_image(device, vk::ImageType::e2D, format, extent, tiling, vk::ImageUsageFlagBits::eDepthStencilAttachment);
@@ -230,15 +346,76 @@ namespace vulkan {
     inline auto create_buffer(vk::Device device, size_t size, vk::BufferUsageFlags usages) {
         return device.createBuffer(vk::BufferCreateInfo{ {}, size, usages });
     }
+    inline auto create_timeline_semaphore(vk::Device device) {
+        vk::StructureChain create_info{
+            vk::SemaphoreCreateInfo{},
+            vk::SemaphoreTypeCreateInfo{}.setSemaphoreType(vk::SemaphoreType::eTimeline).setInitialValue(0),
+        };
+        return device.createSemaphore(create_info.get<vk::SemaphoreCreateInfo>());
+    }
+    // copies a tightly packed buffer, layer after layer, into the whole image and leaves it in eShaderReadOnlyOptimal.
+    // Across queue families the last barrier is the release half of an ownership transfer, record_texture_acquire is the other.
+    inline void record_texture_upload(vk::CommandBuffer cmd, vk::Image image, vk::Buffer buffer, vk::Extent2D extent, uint32_t layers,
+        uint32_t upload_queue_family_index, uint32_t graphics_queue_family_index) {
+        auto subresource_range = vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, layers };
+        auto to_transfer = vk::ImageMemoryBarrier2{}
+            .setDstStageMask(vk::PipelineStageFlagBits2::eCopy)
+            .setDstAccessMask(vk::AccessFlagBits2::eTransferWrite)
+            .setOldLayout(vk::ImageLayout::eUndefined)
+            .setNewLayout(vk::ImageLayout::eTransferDstOptimal)
+            .setImage(image)
+            .setSubresourceRange(subresource_range);
+        cmd.pipelineBarrier2(vk::DependencyInfo{}.setImageMemoryBarriers(to_transfer));
+        cmd.copyBufferToImage(buffer, image, vk::ImageLayout::eTransferDstOptimal,
+            vk::BufferImageCopy{}
+            .setImageSubresource(vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, 0, 0, layers })
+            .setImageExtent(vk::Extent3D{ extent, 1 }));
+        auto to_shader = vk::ImageMemoryBarrier2{}
+            .setSrcStageMask(vk::PipelineStageFlagBits2::eCopy)
+            .setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite)
+            .setOldLayout(vk::ImageLayout::eTransferDstOptimal)
+            .setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
+            .setImage(image)
+            .setSubresourceRange(subresource_range);
+        if (upload_queue_family_index != graphics_queue_family_index) {
+            to_shader.setSrcQueueFamilyIndex(upload_queue_family_index).setDstQueueFamilyIndex(graphics_queue_family_index);
+        }
+        else {
+            to_shader.setDstStageMask(vk::PipelineStageFlagBits2::eFragmentShader).setDstAccessMask(vk::AccessFlagBits2::eShaderSampledRead);
+        }
+        cmd.pipelineBarrier2(vk::DependencyInfo{}.setImageMemoryBarriers(to_shader));
+    }
+    inline void record_texture_acquire(vk::CommandBuffer cmd, vk::Image image, uint32_t layers,
+        uint32_t upload_queue_family_index, uint32_t graphics_queue_family_index) {
+        auto acquire = vk::ImageMemoryBarrier2{}
+            .setDstStageMask(vk::PipelineStageFlagBits2::eFragmentShader)
+            .setDstAccessMask(vk::AccessFlagBits2::eShaderSampledRead)
+            .setOldLayout(vk::ImageLayout::eTransferDstOptimal)
+            .setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
+            .setSrcQueueFamilyIndex(upload_queue_family_index)
+            .setDstQueueFamilyIndex(graphics_queue_family_index)
+            .setImage(image)
+            .setSubresourceRange(vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, layers });
+        cmd.pipelineBarrier2(vk::DependencyInfo{}.setImageMemoryBarriers(acquire));
+    }
+    template<class E, class T>
+    inline void copy_to_mapped_memory(E* ptr, const T& data) {
+        if constexpr (std::ranges::contiguous_range<const T>) {
+            std::ranges::copy(data, ptr);
+        }
+        else {
+            int i = 0;
+            for (auto ite = data.begin(); ite != data.end(); ++ite) {
+                ptr[i++] = *ite;
+            }
+        }
+    }
     template<class T>
     inline void copy_to_buffer(vk::Device device, vk::Buffer buffer, vk::DeviceMemory memory, T data) {
         auto memory_requirement = device.getBufferMemoryRequirements(buffer);
         using ele_type = std::remove_reference_t<decltype(*data.begin())>;
         auto* ptr = static_cast<ele_type*>(device.mapMemory(memory, 0, memory_requirement.size));
-        int i = 0;
-        for (auto ite = data.begin(); ite != data.end(); ++ite) {
-            ptr[i++] = *ite;
-        }
+        copy_to_mapped_memory(ptr, data);
         device.unmapMemory(memory);
     }
     template<class T>
@@ -260,6 +437,16 @@ namespace vulkan {
     inline auto create_pipeline_layout(vk::Device device, vk::DescriptorSetLayout descriptor_set_layout) {
         return device.createPipelineLayout(vk::PipelineLayoutCreateInfo{}.setSetLayouts(descriptor_set_layout));
     }
+    inline auto create_pipeline_layout(vk::Device device, vk::DescriptorSetLayout descriptor_set_layout, std::span<const vk::PushConstantRange> push_constant_ranges) {
+        return device.createPipelineLayout(
+            vk::PipelineLayoutCreateInfo{}
+            .setSetLayouts(descriptor_set_layout)
+            .setPushConstantRanges(push_constant_ranges));
+    }
+    // for pipelines that bind no descriptor sets.
+    inline auto create_pipeline_layout(vk::Device device, std::span<const vk::PushConstantRange> push_constant_ranges) {
+        return device.createPipelineLayout(vk::PipelineLayoutCreateInfo{}.setPushConstantRanges(push_constant_ranges));
+    }
     inline auto create_render_pass(vk::Device device, vk::Format colorFormat, vk::Format depthFormat) {
         std::array<vk::AttachmentDescription, 2> attachmentDescriptions;
         attachmentDescriptions[0] = vk::AttachmentDescription(vk::AttachmentDescriptionFlags(),
@@ -318,13 +505,14 @@ namespace vulkan {
     struct vertex_stage_info {
         std::filesystem::path shader_file_path;
         std::string entry_name;
-        vk::VertexInputBindingDescription input_binding;
+        std::vector<vk::VertexInputBindingDescription> input_bindings;
         std::vector<vk::VertexInputAttributeDescription> input_attributes;
         vk::SpecializationInfo specialization_info;
     };
     struct task_stage_info {
         std::filesystem::path shader_file_path;
         std::string entry_name;
+        vk::SpecializationInfo specialization_info;
     };
     struct mesh_stage_info {
         std::filesystem::path shader_file_path;
@@ -340,7 +528,8 @@ namespace vulkan {
         mesh_stage_info mesh_stage_info,
         std::filesystem::path fragment_shader,
         vk::RenderPass render_pass,
-        vk::PipelineLayout layout) {
+        vk::PipelineLayout layout,
+        vk::PipelineCache pipeline_cache = {}) {
         auto task_shader_module = create_shader_module(device, task_stage_info.shader_file_path);
         auto mesh_shader_module = create_shader_module(device, mesh_stage_info.shader_file_path);
         auto fragment_shader_module = create_shader_module(device, fragment_shader);
@@ -348,7 +537,8 @@ namespace vulkan {
             vk::PipelineShaderStageCreateInfo{}
             .setStage(vk::ShaderStageFlagBits::eTaskEXT)
             .setModule(*task_shader_module)
-            .setPName(task_stage_info.entry_name.c_str()),
+            .setPName(task_stage_info.entry_name.c_str())
+            .setPSpecializationInfo(&task_stage_info.specialization_info),
             vk::PipelineShaderStageCreateInfo{{}, vk::ShaderStageFlagBits::eMeshEXT, *mesh_shader_module, mesh_stage_info.entry_name.c_str()}
             .setPSpecializationInfo(&mesh_stage_info.specialization_info),
             vk::PipelineShaderStageCreateInfo{{}, vk::ShaderStageFlagBits::eFragment, *fragment_shader_module, "main"},
@@ -377,7 +567,7 @@ namespace vulkan {
         color_blend_state_create_info.setAttachments(color_blend_attachments);
         std::array<vk::DynamicState, 2> dynamic_states = { vk::DynamicState::eViewport, vk::DynamicState::eScissor };
         vk::PipelineDynamicStateCreateInfo dynamic_state_create_info{ vk::PipelineDynamicStateCreateFlags{}, dynamic_states };
-        return device.createGraphicsPipeline(nullptr,
+        return device.createGraphicsPipeline(pipeline_cache,
             vk::GraphicsPipelineCreateInfo{ {},
                 shader_stage_create_infos ,nullptr, nullptr,
                 nullptr, &viewport_state_create_info, &rasterization_state_create_info, &multisample_state_create_info,
@@ -386,7 +576,8 @@ namespace vulkan {
     inline auto create_pipeline(vk::Device device,
         mesh_stage_info mesh_stage_info, std::filesystem::path fragment_shader,
         vk::RenderPass render_pass,
-        vk::PipelineLayout layout) {
+        vk::PipelineLayout layout,
+        vk::PipelineCache pipeline_cache = {}) {
         auto mesh_shader_module = create_shader_module(device, mesh_stage_info.shader_file_path);
         auto fragment_shader_module = create_shader_module(device, fragment_shader);
         auto shader_stage_create_infos = std::array{
@@ -405,7 +596,7 @@ namespace vulkan {
         color_blend_state_create_info.setAttachments(color_blend_attachments);
         std::array<vk::DynamicState, 2> dynamic_states = { vk::DynamicState::eViewport, vk::DynamicState::eScissor };
         vk::PipelineDynamicStateCreateInfo dynamic_state_create_info{ vk::PipelineDynamicStateCreateFlags{}, dynamic_states };
-        return device.createGraphicsPipeline(nullptr,
+        return device.createGraphicsPipeline(pipeline_cache,
             vk::GraphicsPipelineCreateInfo{ {},
                 shader_stage_create_infos ,nullptr, nullptr,
                 nullptr, &viewport_state_create_info, &rasterization_state_create_info, &multisample_state_create_info,
@@ -415,7 +606,8 @@ namespace vulkan {
     inline auto create_pipeline(vk::Device device,
         vertex_stage_info vertex_stage, std::filesystem::path fragment_shader,
         vk::RenderPass render_pass,
-        vk::PipelineLayout layout
+        vk::PipelineLayout layout,
+        vk::PipelineCache pipeline_cache = {}
     ) {
         auto vertex_shader_module = create_shader_module(device, vertex_stage.shader_file_path);
         auto fragment_shader_module = create_shader_module(device, fragment_shader);
@@ -423,7 +615,7 @@ namespace vulkan {
             vk::PipelineShaderStageCreateInfo{{}, vk::ShaderStageFlagBits::eVertex, *vertex_shader_module, vertex_stage.entry_name.c_str()}.setPSpecializationInfo(&vertex_stage.specialization_info),
             vk::PipelineShaderStageCreateInfo{{}, vk::ShaderStageFlagBits::eFragment, *fragment_shader_module, "main"},
         };
-        vk::PipelineVertexInputStateCreateInfo vertex_input_state_create_info{ {}, vertex_stage.input_binding, vertex_stage.input_attributes };
+        vk::PipelineVertexInputStateCreateInfo vertex_input_state_create_info{ {}, vertex_stage.input_bindings, vertex_stage.input_attributes };
         vk::PipelineInputAssemblyStateCreateInfo input_assembly_state_create_info{ {}, vk::PrimitiveTopology::eTriangleList };
         vk::PipelineViewportStateCreateInfo viewport_state_create_info{ {}, 1, nullptr, 1, nullptr };
         vk::PipelineRasterizationStateCreateInfo rasterization_state_create_info{ {}, false, false, vk::PolygonMode::eFill, vk::CullModeFlagBits::eNone, vk::FrontFace::eClockwise, false, 0.0f, 0.0f, 0.0f, 1.0f };
@@ -448,7 +640,7 @@ namespace vulkan {
         color_blend_state_create_info.setAttachments(color_blend_attachments);
         std::array<vk::DynamicState, 2> dynamic_states = { vk::DynamicState::eViewport, vk::DynamicState::eScissor };
         vk::PipelineDynamicStateCreateInfo dynamic_state_create_info{ vk::PipelineDynamicStateCreateFlags{}, dynamic_states };
-        return device.createGraphicsPipeline(nullptr,
+        return device.createGraphicsPipeline(pipeline_cache,
             vk::GraphicsPipelineCreateInfo{ {},
                 shader_stage_create_infos ,&vertex_input_state_create_info, &input_assembly_state_create_info,
                 nullptr, &viewport_state_create_info, &rasterization_state_create_info, &multisample_state_create_info,
@@ -460,7 +652,8 @@ namespace vulkan {
         geometry_stage_info geometry_stage,
         std::filesystem::path fragment_shader,
         vk::RenderPass render_pass,
-        vk::PipelineLayout layout
+        vk::PipelineLayout layout,
+        vk::PipelineCache pipeline_cache = {}
     ) {
         auto vertex_shader_module = create_shader_module(device, vertex_stage.shader_file_path);
         auto geometry_shader_module = create_shader_module(device, geometry_stage.shader_file_path);
@@ -470,7 +663,7 @@ namespace vulkan {
             vk::PipelineShaderStageCreateInfo{{}, vk::ShaderStageFlagBits::eGeometry, *geometry_shader_module, geometry_stage.entry_name.c_str()},
             vk::PipelineShaderStageCreateInfo{{}, vk::ShaderStageFlagBits::eFragment, *fragment_shader_module, "main"},
         };
-        vk::PipelineVertexInputStateCreateInfo vertex_input_state_create_info{ {}, vertex_stage.input_binding, vertex_stage.input_attributes };
+        vk::PipelineVertexInputStateCreateInfo vertex_input_state_create_info{ {}, vertex_stage.input_bindings, vertex_stage.input_attributes };
         vk::PipelineInputAssemblyStateCreateInfo input_assembly_state_create_info{ {}, vk::PrimitiveTopology::eTriangleList };
         vk::PipelineViewportStateCreateInfo viewport_state_create_info{ {}, 1, nullptr, 1, nullptr };
         vk::PipelineRasterizationStateCreateInfo rasterization_state_create_info{ {}, false, false, vk::PolygonMode::eFill, vk::CullModeFlagBits::eNone, vk::FrontFace::eClockwise, false, 0.0f, 0.0f, 0.0f, 1.0f };
@@ -495,7 +688,7 @@ namespace vulkan {
         color_blend_state_create_info.setAttachments(color_blend_attachments);
         std::array<vk::DynamicState, 2> dynamic_states = { vk::DynamicState::eViewport, vk::DynamicState::eScissor };
         vk::PipelineDynamicStateCreateInfo dynamic_state_create_info{ vk::PipelineDynamicStateCreateFlags{}, dynamic_states };
-        return device.createGraphicsPipeline(nullptr,
+        return device.createGraphicsPipeline(pipeline_cache,
             vk::GraphicsPipelineCreateInfo{ {},
                 shader_stage_create_infos ,&vertex_input_state_create_info, &input_assembly_state_create_info,
                 nullptr, &viewport_state_create_info, &rasterization_state_create_info, &multisample_state_create_info,
@@ -536,45 +729,202 @@ namespace vulkan {
         assert(swapchainCreateInfo.minImageCount >= surfaceCapabilities.minImageCount);
         return device.createSwapchainKHR(swapchainCreateInfo);
     }
-    // reuse_semaphore will be used again, so we need a fence to notify cpu that it is not used by gpu.
-    struct reuse_semaphore {
-        vk::Fence fence;
-        vk::Semaphore semaphore;
-    };
-    class present_manager {
+    // Frame synchronization on one timeline semaphore of the graphics queue. Every submission signals the next
+    // value, so whether frame N is done is a counter read and waiting for it is a single host wait.
+    // Swapchain image acquires can only signal binary semaphores, there is one per frame in flight and it is
+    // reused once the frame that waited on it is done.
+    class frame_timeline {
     public:
-        present_manager(vk::SharedDevice device, uint32_t count) : m_device{ device }, next_semaphore_index{ 0 } {
-            for (int i = 0; i < count; i++) {
-                m_semaphores.push_back(reuse_semaphore{ m_device->createFence(vk::FenceCreateInfo{vk::FenceCreateFlagBits::eSignaled}), m_device->createSemaphore(vk::SemaphoreCreateInfo{}) });
+        struct frame {
+            uint64_t value;
+            vk::Semaphore acquire_semaphore;
+            // which of the frames in flight, resources indexed by it are free again.
+            uint32_t index;
+        };
+        frame_timeline(vk::SharedDevice device, uint32_t frames_in_flight)
+            : m_device{ device },
+            m_timeline{ create_timeline_semaphore(*device), device },
+            m_next_value{ 1 },
+            m_submitted_value{ 0 } {
+            for (uint32_t i = 0; i < frames_in_flight; i++) {
+                m_acquire_slots.emplace_back(acquire_slot{ vk::SharedSemaphore{ device->createSemaphore(vk::SemaphoreCreateInfo{}), device }, 0 });
             }
         }
-        auto get_next() {
-            auto [fence, semaphore] = m_semaphores[next_semaphore_index++];
-            if (next_semaphore_index >= m_semaphores.size()) {
-                next_semaphore_index = 0;
+        frame_timeline(const frame_timeline&) = delete;
+        frame_timeline& operator=(const frame_timeline&) = delete;
+        ~frame_timeline() {
+            wait_idle();
+        }
+        // only blocks when the frame that last used the acquire semaphore is still running. The frame gets its
+        // value from acquired, so an acquire that throws or a frame that is skipped reserves nothing that
+        // later waits would block on.
+        frame begin_frame() {
+            auto index = static_cast<uint32_t>(m_next_acquire_slot++ % m_acquire_slots.size());
+            auto& slot = m_acquire_slots[index];
+            wait(slot.value);
+            return frame{ 0, *slot.semaphore, index };
+        }
+        // after the swapchain image was acquired with the frame's semaphore, the frame must then be submitted
+        // with signal(frame.value).
+        void acquired(frame& frame) {
+            frame.value = reserve_value();
+            m_acquire_slots[frame.index].value = frame.value;
+        }
+        // a value for a submission between frames, like an ownership acquire. Values are submitted in order.
+        uint64_t reserve_value() {
+            return m_next_value++;
+        }
+        vk::SemaphoreSubmitInfo signal(uint64_t value) {
+            m_submitted_value = value;
+            return vk::SemaphoreSubmitInfo{}.setSemaphore(*m_timeline).setValue(value).setStageMask(vk::PipelineStageFlagBits2::eAllCommands);
+        }
+        vk::SharedSemaphore get_semaphore() const {
+            return m_timeline;
+        }
+        uint32_t get_frames_in_flight() const {
+            return static_cast<uint32_t>(m_acquire_slots.size());
+        }
+        uint64_t get_completed_value() const {
+            return m_device->getSemaphoreCounterValue(*m_timeline);
+        }
+        bool is_complete(uint64_t value) const {
+            return get_completed_value() >= value;
+        }
+        void wait(uint64_t value) const {
+            if (is_complete(value)) {
+                return;
             }
-            auto res = m_device->waitForFences(std::array<vk::Fence, 1>{fence}, true, UINT64_MAX);
+            auto res = m_device->waitSemaphores(vk::SemaphoreWaitInfo{}.setSemaphores(*m_timeline).setValues(value), UINT64_MAX);
             assert(res == vk::Result::eSuccess);
-            m_device->resetFences(std::array<vk::Fence, 1>{fence});
-            return reuse_semaphore{ fence, semaphore };
         }
-        void wait_all() {
-            std::ranges::for_each(m_semaphores, [&m_device = m_device](auto reuse_semaphore) {
-                auto res = m_device->waitForFences(std::array<vk::Fence, 1>{reuse_semaphore.fence}, true, UINT64_MAX);
-                assert(res == vk::Result::eSuccess);
-                });
+        // waits for everything signaled so far.
+        void wait_idle() const {
+            wait(m_submitted_value);
+        }
+    private:
+        struct acquire_slot {
+            vk::SharedSemaphore semaphore;
+            // the frame that waits on the semaphore.
+            uint64_t value;
+        };
+        vk::SharedDevice m_device;
+        vk::SharedSemaphore m_timeline;
+        std::vector<acquire_slot> m_acquire_slots;
+        size_t m_next_acquire_slot{ 0 };
+        uint64_t m_next_value;
+        uint64_t m_submitted_value;
+    };
+    // sub allocates buffer memory from big blocks, so small buffers of many windows do not cost an allocation each.
+    // allocations may be made and released from any thread.
+    class memory_pool {
+    public:
+        static constexpr vk::DeviceSize default_block_size = 4 * 1024 * 1024;
+        struct allocation {
+            vk::DeviceMemory memory;
+            vk::DeviceSize offset;
+            vk::DeviceSize size;
+            // nullptr if the memory is not host visible.
+            void* mapped;
+        };
+        memory_pool(vk::SharedPhysicalDevice physical_device, vk::SharedDevice device, vk::DeviceSize block_size = default_block_size)
+            : m_physical_device{ physical_device }, m_device{ device }, m_block_size{ block_size } {}
+        // the range goes back to the pool when the last reference to the allocation is released.
+        std::shared_ptr<allocation> allocate(vk::MemoryRequirements requirements, vk::MemoryPropertyFlags properties) {
+            uint32_t type_index = select_memory_type(*m_physical_device, *m_device, requirements, properties);
+            std::lock_guard lock{ *m_mutex };
+            auto& blocks = m_blocks[type_index];
+            for (auto& block : blocks) {
+                if (auto offset = block->reserve(requirements.size, requirements.alignment)) {
+                    return make_allocation(block, *offset, requirements.size);
+                }
+            }
+            blocks.push_back(std::make_shared<memory_block>(m_device,
+                std::max(m_block_size, requirements.size), type_index,
+                contain_bit(properties, vk::MemoryPropertyFlagBits::eHostVisible)));
+            auto offset = blocks.back()->reserve(requirements.size, requirements.alignment);
+            assert(offset.has_value());
+            return make_allocation(blocks.back(), *offset, requirements.size);
         }
-        ~present_manager() {
-            wait_all();
-            std::ranges::for_each(m_semaphores, [&m_device = m_device](auto reuse_semaphore) {
-                m_device->destroyFence(reuse_semaphore.fence);
-                m_device->destroySemaphore(reuse_semaphore.semaphore);
+        vk::DeviceSize get_allocated_size() const {
+            std::lock_guard lock{ *m_mutex };
+            return std::accumulate(m_blocks.begin(), m_blocks.end(), vk::DeviceSize{ 0 }, [](auto sum, auto& type_blocks) {
+                return std::accumulate(type_blocks.second.begin(), type_blocks.second.end(), sum, [](auto sum, auto& block) {
+                    return sum + block->get_size();
+                    });
                 });
         }
     private:
+        class memory_block {
+        public:
+            memory_block(vk::SharedDevice device, vk::DeviceSize size, uint32_t type_index, bool host_visible)
+                : m_memory{ device->allocateMemory(vk::MemoryAllocateInfo{ size, type_index }), device },
+                m_size{ size },
+                m_mapped{ host_visible ? device->mapMemory(*m_memory, 0, size) : nullptr },
+                m_free_ranges{ {0, size} } {}
+            std::optional<vk::DeviceSize> reserve(vk::DeviceSize size, vk::DeviceSize alignment) {
+                for (auto ite = m_free_ranges.begin(); ite != m_free_ranges.end(); ++ite) {
+                    auto [begin, end] = *ite;
+                    auto offset = (begin + alignment - 1) / alignment * alignment;
+                    if (offset + size <= end) {
+                        m_free_ranges.erase(ite);
+                        if (begin < offset) {
+                            m_free_ranges.emplace(begin, offset);
+                        }
+                        if (offset + size < end) {
+                            m_free_ranges.emplace(offset + size, end);
+                        }
+                        return offset;
+                    }
+                }
+                return std::nullopt;
+            }
+            void release(vk::DeviceSize offset, vk::DeviceSize size) {
+                auto begin = offset, end = offset + size;
+                auto next = m_free_ranges.lower_bound(begin);
+                if (next != m_free_ranges.end() && next->first == end) {
+                    end = next->second;
+                    next = m_free_ranges.erase(next);
+                }
+                if (next != m_free_ranges.begin() && std::prev(next)->second == begin) {
+                    begin = std::prev(next)->first;
+                    m_free_ranges.erase(std::prev(next));
+                }
+                m_free_ranges.emplace(begin, end);
+            }
+            vk::DeviceMemory get_memory() const {
+                return *m_memory;
+            }
+            vk::DeviceSize get_size() const {
+                return m_size;
+            }
+            void* get_mapped() const {
+                return m_mapped;
+            }
+        private:
+            vk::SharedDeviceMemory m_memory;
+            vk::DeviceSize m_size;
+            void* m_mapped;
+            // begin -> end of the free ranges.
+            std::map<vk::DeviceSize, vk::DeviceSize> m_free_ranges;
+        };
+        std::shared_ptr<allocation> make_allocation(std::shared_ptr<memory_block> block, vk::DeviceSize offset, vk::DeviceSize size) {
+            auto mapped = block->get_mapped() ? static_cast<char*>(block->get_mapped()) + offset : nullptr;
+            return std::shared_ptr<allocation>{
+                new allocation{ block->get_memory(), offset, size, mapped },
+                [mutex = m_mutex, block, offset, size](allocation* p) {
+                    {
+                        std::lock_guard lock{ *mutex };
+                        block->release(offset, size);
+                    }
+                    delete p;
+                } };
+        }
+        vk::SharedPhysicalDevice m_physical_device;
         vk::SharedDevice m_device;
-        std::vector<reuse_semaphore> m_semaphores;
-        uint32_t next_semaphore_index;
+        vk::DeviceSize m_block_size;
+        // shared with the allocations, which may be released after the pool.
+        std::shared_ptr<std::mutex> m_mutex{ std::make_shared<std::mutex>() };
+        std::map<uint32_t, std::vector<std::shared_ptr<memory_block>>> m_blocks;
     };
     namespace shared {
         inline auto select_physical_device(vk::SharedInstance instance) {
@@ -590,6 +940,11 @@ namespace vulkan {
             vk::CommandPoolCreateInfo commandPoolCreateInfo(vk::CommandPoolCreateFlagBits::eResetCommandBuffer, queue_family_index);
             return vk::SharedCommandPool(device->createCommandPool(commandPoolCreateInfo), device);
         }
+        // for command buffers that are recorded once and dropped with a pool reset.
+        inline auto create_transient_command_pool(vk::SharedDevice device, uint32_t queue_family_index) {
+            vk::CommandPoolCreateInfo commandPoolCreateInfo(vk::CommandPoolCreateFlagBits::eTransient, queue_family_index);
+            return vk::SharedCommandPool(device->createCommandPool(commandPoolCreateInfo), device);
+        }
         inline auto get_surface(vk::SharedInstance instance, auto&& get_surface_fun) {
             vk::SurfaceKHR vk_surface = get_surface_fun(*instance);
             return vk::SharedSurfaceKHR{ vk_surface, instance };